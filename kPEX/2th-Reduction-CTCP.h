@@ -11,8 +11,9 @@ class Reduction
 private:
     ui *triangles;
     Graph *g;
+    GraphWorkspace &ws;
     ui n, m;
-    vector<bool> vis; // a cache when counting triangles
+    EpochMarker vis; // a cache when counting triangles
     ui *edge_to, *pstart, *deg;
     /**
      * @brief count the number of triangles for each edge and save the results in triangls[]
@@ -31,7 +32,7 @@ private:
             {
                 assert(j < m);
                 assert(edge_to[j] < n);
-                vis[edge_to[j]] = 1;
+                vis.set(edge_to[j]);
             }
             for (ui j = pstart[i]; j < pstart[i + 1]; j++)
             {
@@ -42,13 +43,11 @@ private:
                 for (ui a = pstart[v]; a < pstart[v + 1]; a++)
                 {
                     ui w = edge_to[a];
-                    if (vis[w])
-                        cnt++;
+                    cnt += vis[w];
                 }
                 triangles[j] = cnt;
             }
-            for (ui j = pstart[i]; j < pstart[i + 1]; j++)
-                vis[edge_to[j]] = 0;
+            vis.clear();
         }
         for (ui i = 0; i < n; i++)
         {
@@ -93,11 +92,11 @@ private:
     }
 
 public:
-    Reduction(Graph *_g) : g(_g), triangles(nullptr)
+    Reduction(Graph *_g, GraphWorkspace &_ws = GraphWorkspace::local()) : g(_g), ws(_ws), triangles(nullptr)
     {
         n = g->n;
         m = g->m;
-        vis.resize(n, 0);
+        vis.resize(n);
     }
     ~Reduction()
     {
@@ -120,21 +119,21 @@ public:
         ui *q = que;
         if (q == nullptr)
         {
-            q = new ui[n];
+            ws.id_map.resize(n);
+            q = ws.id_map.data();
         }
         ui new_n = 0;
         assert(n == g->map_refresh_id.size());
-        vector<ui> new_map(n);
+        vector<ui> &map_refresh_id = g->map_refresh_id;
         for (ui i = 0; i < n; i++)
             if (!vertex_removed[i])
             {
-                new_map[new_n] = g->map_refresh_id[i];
+                map_refresh_id[new_n] = map_refresh_id[i];
                 q[i] = new_n++;
             }
-        new_map.resize(new_n);
-        g->map_refresh_id = new_map;
-        ui *new_pstart = new ui[new_n + 1];
-        ui *new_d = new ui[new_n];
+        map_refresh_id.resize(new_n);
+        ui *new_pstart = ws.take(GraphWorkspace::PSTART, new_n + 1);
+        ui *new_d = ws.take(GraphWorkspace::DEGREE, new_n);
         ui j = 0;
         for (ui i = 0; i < n; i++)
         {
@@ -151,8 +150,8 @@ public:
             new_d[u] = j - new_pstart[u];
         }
         new_pstart[new_n] = j;
-        delete[] g->d;
-        delete[] g->pstart;
+        ws.give_back(GraphWorkspace::DEGREE, g->d, n);
+        ws.give_back(GraphWorkspace::PSTART, g->pstart, n + 1);
         g->d = new_d;
         g->pstart = new_pstart;
         deg = new_d;
@@ -171,10 +170,6 @@ public:
         }
         g->m = m = j;
         g->n = n = new_n;
-        if (que == nullptr)
-        {
-            delete[] q;
-        }
     }
     /**
      * @brief core-truss co-pruning
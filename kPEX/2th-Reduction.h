@@ -15,23 +15,18 @@ private:
         ui u, edge_id;
         ui remove_time;
     };
-    // my queue
+    // my queue: the memory is borrowed from buf
     class Queue
     {
         ui *q;
         ui hh, tt;
 
     public:
-        Queue(ui max_size) : q(nullptr), hh(1), tt(0)
+        Queue(vector<ui> &buf, ui max_size) : q(nullptr), hh(1), tt(0)
         {
-            q = new ui[max_size + 1];
-        }
-        ~Queue()
-        {
-            if (q != nullptr)
-            {
-                delete[] q;
-            }
+            if (buf.size() < max_size + 1)
+                buf.resize(max_size + 1);
+            q = buf.data();
         }
         void push(ui u)
         {
@@ -52,6 +47,7 @@ private:
     };
     // G-fast: only vertices in G-fast are useful
     Graph &G_fast;
+    GraphWorkspace &ws;
     ui *triangles, *compute_time, *another_edge;
     vector<bool> vertex_removed_from_G_fast, edge_removed_from_G_fast;
     ui n, m;
@@ -59,7 +55,7 @@ private:
     // G-slow: this is used to update triangle count
     vector<bool> edge_removed_from_G_slow;
     // cache
-    vector<bool> vis;
+    EpochMarker vis;
 
     /**
      * @brief reduce G-fast to (lb+1-k)-core
@@ -173,14 +169,15 @@ private:
     {
         ui *pstart = G_fast.pstart, *edge_to = G_fast.edge_to;
         ui *d = G_fast.d;
-        ui *id_map = new ui[n];
+        ws.id_map.resize(n);
+        ui *id_map = ws.id_map.data();
         ui new_n = 0;
-        vector<ui> map_refresh_id(n);
+        vector<ui> &map_refresh_id = G_fast.map_refresh_id;
         for (ui i = 0; i < n; i++)
         {
             if (!vertex_removed_from_G_fast[i])
             {
-                map_refresh_id[new_n] = G_fast.map_refresh_id[i];
+                map_refresh_id[new_n] = map_refresh_id[i];
                 id_map[i] = new_n++;
             }
         }
@@ -192,9 +189,8 @@ private:
                 break;
             }
         map_refresh_id.resize(new_n);
-        G_fast.map_refresh_id = map_refresh_id;
         ui new_m = 0;
-        ui *new_pstart = new ui[new_n + 1];
+        ui *new_pstart = ws.take(GraphWorkspace::PSTART, new_n + 1);
         for (ui u = 0; u < n; u++)
         {
             if (vertex_removed_from_G_fast[u])
@@ -211,21 +207,18 @@ private:
             }
         }
         new_pstart[new_n] = new_m;
-        ui *new_d = new ui[new_n];
+        ui *new_d = ws.take(GraphWorkspace::DEGREE, new_n);
         for (ui i = 0; i < new_n; i++)
             new_d[i] = new_pstart[i + 1] - new_pstart[i];
-        delete[] pstart;
-        delete[] d;
-        delete[] id_map;
+        ws.give_back(GraphWorkspace::PSTART, pstart, n + 1);
+        ws.give_back(GraphWorkspace::DEGREE, d, n);
         G_fast.pstart = new_pstart;
         G_fast.d = new_d;
         n = G_fast.n = new_n;
         m = G_fast.m = new_m;
-        edge_removed_from_G_fast.clear();
-        edge_removed_from_G_fast.resize(m, 0);
-        vertex_removed_from_G_fast.clear();
-        vertex_removed_from_G_fast.resize(n, 0);
-        vis.resize(n, 0);
+        edge_removed_from_G_fast.assign(m, 0);
+        vertex_removed_from_G_fast.assign(n, 0);
+        vis.resize(n);
         return new_idx_u;
     }
 
@@ -256,7 +249,7 @@ private:
                 ui v = edge_to[i];
                 if (vertex_removed_from_G_fast[v])
                     continue;
-                vis[v] = 1;
+                vis.set(v);
             }
             // enmerate the neighbor of u, and each edge we compute only once
             for (ui i = pstart[u]; i < pstart[u + 1]; i++)
@@ -277,23 +270,22 @@ private:
                     ui w = edge_to[j];
                     if (vertex_removed_from_G_fast[w])
                         continue;
-                    if (vis[w]) // w is a common neighbor
-                        edge_cnt++;
+                    edge_cnt += vis[w]; // w is a common neighbor
                 }
                 if (edge_cnt + 2 * paramK <= lb) // remove (u,v)
                 {
-                    edge_removed_from_G_fast[i] = true;
+                    edge_removed_from_G_fast[i] = 1;
                     ui another_edge_id = find(edge_to + pstart[v], edge_to + pstart[v + 1], u) + pstart[v];
-                    edge_removed_from_G_fast[another_edge_id] = true;
+                    edge_removed_from_G_fast[another_edge_id] = 1;
                     if (--d[u] + paramK == lb)
                     {
                         q_v.push(u);
-                        vertex_removed_from_G_fast[u] = true;
+                        vertex_removed_from_G_fast[u] = 1;
                     }
                     if (--d[v] + paramK == lb)
                     {
                         q_v.push(v);
-                        vertex_removed_from_G_fast[v] = true;
+                        vertex_removed_from_G_fast[v] = 1;
                     }
                     if (q_v.size())
                     {
@@ -302,15 +294,10 @@ private:
                             break;
                     }
                     // note that v is not a neighbor of u now
-                    vis[v] = 0;
+                    vis.reset(v);
                 }
             }
-            // clear the cache
-            for (ui i = pstart[u]; i < pstart[u + 1]; i++)
-            {
-                ui v = edge_to[i];
-                vis[v] = 0;
-            }
+            vis.clear(); // clear the cache
             // shrink current graph to boost the computation
             if (remove_vertex_cnt * 4 >= n)
             {
@@ -325,12 +312,12 @@ private:
     }
 
 public:
-    Reduction(Graph *_g) : G_fast(*_g), triangles(nullptr), compute_time(nullptr), another_edge(nullptr),
-                           timestamp(0)
+    Reduction(Graph *_g, GraphWorkspace &_ws = GraphWorkspace::local())
+        : G_fast(*_g), ws(_ws), triangles(nullptr), compute_time(nullptr), another_edge(nullptr), timestamp(0)
     {
         n = G_fast.n;
         m = G_fast.m;
-        vis.resize(n, 0);
+        vis.resize(n);
     }
     ~Reduction()
     {
@@ -351,9 +338,9 @@ public:
         do
         {
             ui previous_m = m, previous_n = n;
-            vertex_removed_from_G_fast.resize(n, 0);
-            edge_removed_from_G_fast.resize(m, 0);
-            Queue q_v(n);
+            vertex_removed_from_G_fast.resize(n);
+            edge_removed_from_G_fast.resize(m);
+            Queue q_v(ws.q, n);
             first_round_reduce(lb, q_v);
             if (previous_m == m) // none of the edges can be reduced
             {
@@ -385,21 +372,21 @@ public:
     {
         ui *pstart = G_fast.pstart, *edge_to = G_fast.edge_to;
         ui *d = G_fast.d;
-        ui *id_map = new ui[n];
+        ws.id_map.resize(n);
+        ui *id_map = ws.id_map.data();
         ui new_n = 0;
-        vector<ui> map_refresh_id(n);
+        vector<ui> &map_refresh_id = G_fast.map_refresh_id;
         for (ui i = 0; i < n; i++)
         {
             if (!vertex_removed_from_G_fast[i])
             {
-                map_refresh_id[new_n] = G_fast.map_refresh_id[i];
+                map_refresh_id[new_n] = map_refresh_id[i];
                 id_map[i] = new_n++;
             }
         }
         map_refresh_id.resize(new_n);
-        G_fast.map_refresh_id = map_refresh_id;
         ui new_m = 0;
-        ui *new_pstart = new ui[new_n + 1];
+        ui *new_pstart = ws.take(GraphWorkspace::PSTART, new_n + 1);
         for (ui u = 0; u < n; u++)
         {
             if (vertex_removed_from_G_fast[u])
@@ -416,12 +403,11 @@ public:
             }
         }
         new_pstart[new_n] = new_m;
-        ui *new_d = new ui[new_n];
+        ui *new_d = ws.take(GraphWorkspace::DEGREE, new_n);
         for (ui i = 0; i < new_n; i++)
             new_d[i] = new_pstart[i + 1] - new_pstart[i];
-        delete[] pstart;
-        delete[] d;
-        delete[] id_map;
+        ws.give_back(GraphWorkspace::PSTART, pstart, n + 1);
+        ws.give_back(GraphWorkspace::DEGREE, d, n);
         G_fast.pstart = new_pstart;
         G_fast.d = new_d;
         n = G_fast.n = new_n;
@@ -453,7 +439,7 @@ public:
                 ui v = edge_to[i];
                 if (vertex_removed_from_G_fast[v])
                     continue;
-                vis[v] = 1;
+                vis.set(v);
             }
             // enmerate the neighbor of u, and each edge we compute only once
             for (ui i = pstart[u]; i < pstart[u + 1]; i++)
@@ -474,8 +460,7 @@ public:
                     ui w = edge_to[j];
                     if (vertex_removed_from_G_fast[w])
                         continue;
-                    if (vis[w]) // w is a common neighbor
-                        edge_cnt++;
+                    edge_cnt += vis[w]; // w is a common neighbor
                 }
                 if (edge_cnt + 2 * paramK <= lb) // remove (u,v)
                 {
@@ -484,7 +469,7 @@ public:
                         break;
                     else // note that the neighbors of u are changed so we need to update vis
                     {
-                        vis[v] = 0;
+                        vis.reset(v);
                     }
                 }
                 else
@@ -496,12 +481,7 @@ public:
                     compute_time[another_edge_id] = timestamp;
                 }
             }
-            // clear the cache
-            for (ui i = pstart[u]; i < pstart[u + 1]; i++)
-            {
-                ui v = edge_to[i];
-                vis[v] = 0;
-            }
+            vis.clear(); // clear the cache
         }
         list_triangle_time += t.get_time();
         if (!q_e.size())
@@ -4,6 +4,111 @@
 #include "LinearHeap.h"
 #include "MyBitset.h"
 
+/**
+ * @brief scratch memory of the graph rebuilds (remove_v, weak_reduce, degeneracy_and_reduce and Reduction):
+ * queues, id maps and one spare set of CSR arrays; a rebuild fills the spare arrays and hands the old ones back,
+ * so the arrays ping-pong between the graph and the workspace instead of being re-allocated
+ */
+class GraphWorkspace
+{
+    ui *spare[3];
+    size_t spare_cap[3];
+
+public:
+    enum
+    {
+        PSTART = 0,
+        DEGREE = 1,
+        EDGE = 2
+    };
+    vector<ui> q;         // queue
+    vector<ui> id_map;    // old id -> new id
+    vector<ui> core, seq; // used by degeneracy_and_reduce
+
+    GraphWorkspace()
+    {
+        for (int i = 0; i < 3; i++)
+            spare[i] = nullptr, spare_cap[i] = 0;
+    }
+    GraphWorkspace(const GraphWorkspace &) = delete;
+    GraphWorkspace &operator=(const GraphWorkspace &) = delete;
+    ~GraphWorkspace()
+    {
+        release();
+    }
+
+    /**
+     * @brief the workspace of the calling thread
+     */
+    static GraphWorkspace &local()
+    {
+        static thread_local GraphWorkspace ws;
+        return ws;
+    }
+
+    /**
+     * @brief make sure that a graph with n vertices and m edges can be rebuilt without allocation
+     */
+    void reserve(ui n, ui m)
+    {
+        give_back(PSTART, take(PSTART, n + 1), n + 1);
+        give_back(DEGREE, take(DEGREE, n), n);
+        give_back(EDGE, take(EDGE, m), m);
+        q.reserve(n + 1);
+        id_map.reserve(n);
+    }
+
+    /**
+     * @brief free all memory, e.g., when the graph becomes much smaller than the input graph
+     */
+    void release()
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            if (spare[i] != nullptr)
+                delete[] spare[i];
+            spare[i] = nullptr, spare_cap[i] = 0;
+        }
+        vector<ui>().swap(q);
+        vector<ui>().swap(id_map);
+        vector<ui>().swap(core);
+        vector<ui>().swap(seq);
+    }
+
+    /**
+     * @brief take the spare array of the kind, whose capacity is at least need
+     */
+    ui *take(int kind, size_t need)
+    {
+        ui *ret = spare[kind];
+        if (ret == nullptr || spare_cap[kind] < need)
+        {
+            if (ret != nullptr)
+                delete[] ret;
+            ret = new ui[need];
+        }
+        spare[kind] = nullptr, spare_cap[kind] = 0;
+        return ret;
+    }
+
+    /**
+     * @brief hand an array with at least cap elements back as the spare of the kind; we keep the larger one
+     */
+    void give_back(int kind, ui *arr, size_t cap)
+    {
+        if (arr == nullptr)
+            return;
+        if (spare[kind] != nullptr && spare_cap[kind] >= cap)
+        {
+            delete[] arr;
+            return;
+        }
+        if (spare[kind] != nullptr)
+            delete[] spare[kind];
+        spare[kind] = arr, spare_cap[kind] = cap;
+    }
+};
+
 /**
  * used for heuristic & preprocess
  */
@@ -44,6 +149,54 @@ public:
         pstart[n] = j;
         assert(j == m);
     }
+    /**
+     * @brief copy a graph stored in CSR, i.e., the neighbors of u are _edge_to[_pstart[u], _pstart[u+1])
+     */
+    Graph(vector<int> &ids, vector<ui> &_pstart, vector<ui> &_edge_to, GraphWorkspace &ws = GraphWorkspace::local())
+        : d(nullptr), edge_to(nullptr), pstart(nullptr)
+    {
+        n = ids.size();
+        map_refresh_id.assign(ids.begin(), ids.end());
+        m = _pstart[n];
+        d = ws.take(GraphWorkspace::DEGREE, n);
+        edge_to = ws.take(GraphWorkspace::EDGE, m);
+        pstart = ws.take(GraphWorkspace::PSTART, n + 1);
+        memcpy(pstart, _pstart.data(), sizeof(ui) * (n + 1));
+        memcpy(edge_to, _edge_to.data(), sizeof(ui) * m);
+        for (ui u = 0; u < n; u++)
+            d[u] = pstart[u + 1] - pstart[u];
+    }
+    /**
+     * @brief deep copy, e.g., a loaded graph is kept by the caller and each query reduces its own copy
+     */
+    Graph(const Graph &other) : n(other.n), m(other.m), d(nullptr), edge_to(nullptr), pstart(nullptr),
+                                map_refresh_id(other.map_refresh_id)
+    {
+        if (other.pstart == nullptr)
+            return;
+        d = new ui[n];
+        edge_to = new ui[m];
+        pstart = new ui[n + 1];
+        memcpy(d, other.d, sizeof(ui) * n);
+        memcpy(edge_to, other.edge_to, sizeof(ui) * m);
+        memcpy(pstart, other.pstart, sizeof(ui) * (n + 1));
+    }
+    Graph(Graph &&other) : n(other.n), m(other.m), d(other.d), edge_to(other.edge_to), pstart(other.pstart),
+                           map_refresh_id(move(other.map_refresh_id))
+    {
+        other.d = other.edge_to = other.pstart = nullptr;
+        other.n = other.m = 0;
+    }
+    Graph &operator=(Graph other)
+    {
+        swap(n, other.n);
+        swap(m, other.m);
+        swap(d, other.d);
+        swap(edge_to, other.edge_to);
+        swap(pstart, other.pstart);
+        swap(map_refresh_id, other.map_refresh_id);
+        return *this;
+    }
     ~Graph()
     {
         if (d != nullptr)
@@ -54,6 +207,17 @@ public:
         if (pstart != nullptr)
             delete[] pstart;
     }
+    /**
+     * @brief hand the CSR arrays to ws so that the next graph built from ws can reuse them; the graph becomes empty
+     */
+    void recycle(GraphWorkspace &ws = GraphWorkspace::local())
+    {
+        ws.give_back(GraphWorkspace::PSTART, pstart, n + 1);
+        ws.give_back(GraphWorkspace::DEGREE, d, n);
+        ws.give_back(GraphWorkspace::EDGE, edge_to, m);
+        pstart = d = edge_to = nullptr;
+        n = m = 0;
+    }
     /**
      * @brief degeneracy on g_i of ego net
      */
@@ -155,9 +319,7 @@ public:
         ifstream in(file_path);
         if (!in.is_open())
         {
-            printf("Failed to open %s \n", file_path.c_str());
-            fflush(stdout);
-            exit(1);
+            throw runtime_error("Failed to open " + file_path);
         }
         string suffix = get_file_name_suffix(file_path);
         if (suffix == "mtx")
@@ -278,15 +440,15 @@ public:
             FILE *in = fopen(file_path.c_str(), "rb");
             if (in == nullptr)
             {
-                printf("Failed to open %s \n", file_path.c_str());
-                exit(1);
+                throw runtime_error("Failed to open " + file_path);
             }
             ui size_int;
             fread(&size_int, sizeof(ui), 1, in);
             if (size_int != sizeof(ui))
             {
-                printf("sizeof int is different: graph_file(%u), machine(%u)\n", size_int, (int)sizeof(ui));
-                exit(1);
+                fclose(in);
+                throw runtime_error("sizeof int is different: graph_file(" + to_string(size_int) + "), machine(" +
+                                    to_string(sizeof(ui)) + ")");
             }
             fread(&n, sizeof(ui), 1, in);
             fread(&m, sizeof(ui), 1, in);
@@ -420,12 +582,14 @@ public:
     /**
      * @brief stage-I: induce a subgraph
      */
-    int degen_on_subgraph(ui u, vector<int> &deg_in_g, vector<int> &cnt, vector<bool> &vertex_removed,
+    int degen_on_subgraph(ui u, EpochArray<int> &deg_in_g, EpochArray<int> &cnt, vector<bool> &vertex_removed,
                           set<ui> &solution, bool &pruned)
     {
         if (vertex_removed[u])
             return paramK;
         pruned = false;
+        deg_in_g.clear(); // deg_in_g[v]=0 for all v
+        cnt.clear();      // cnt[v]=-1 for all v
         vector<ui> candidate; // 2-hops neighbors of u
         // get the subgraph
         // 1. get the neighbors of u, and they should form a (lb+1-2k)-core
@@ -489,12 +653,6 @@ public:
         candidate.resize(rest_cnt);
         if (rest_cnt + paramK < lb + 1) // current subgraph can be pruned
         {
-            // clear the arrays
-            for (ui v : candidate)
-            {
-                cnt[v] = -1;
-                deg_in_g[v] = 0;
-            }
             pruned = true;
             return paramK;
         }
@@ -528,9 +686,6 @@ public:
         if (candidate.size() + 1 <= lb)
         {
             pruned = true;
-            for (ui w : candidate)
-                cnt[w] = -1;
-            cnt[u] = -1;
             return paramK;
         }
         candidate.push_back(u);
@@ -558,17 +713,12 @@ public:
             for (int u : plex)
                 solution.insert(map_refresh_id[candidate[u]]);
         }
-        // clear the arrays
-        for (ui v : candidate)
-        {
-            cnt[v] = -1;
-            deg_in_g[v] = 0;
-        }
         return degen_lb;
     }
     /**
      * @brief StrongHeuris
      *
+     * @param time_limit stop after about time_limit microseconds, 0 means no limit
      * @return lb
      */
     int strong_heuris(int lb, set<ui> &solution, double time_limit)
@@ -577,13 +727,15 @@ public:
         int ret = lb;
         ui *seq = new ui[n];
         sort_by_degree(seq, 0);
-        // the following arrays are shared for each extending procedure and we need to clear them each time
+        // the following arrays are shared for each extending procedure and are cleared in O(1) each time
         vector<int> deg_in_S(n, -1);    // if deg_in_S[u]=-1, then u is not in S
-        vector<int> deg_in_g(n, 0);     // g is subgraph induced by the 2-hop-neighbors of u
-        vector<int> cnt(n, -1);         // cnt[v] = the edge count between S and v; if cnt[v]=-1, then v is not in candidate set
+        EpochArray<int> deg_in_g(n, 0); // g is subgraph induced by the 2-hop-neighbors of u
+        EpochArray<int> cnt(n, -1);     // cnt[v] = the edge count between S and v; if cnt[v]=-1, then v is not in candidate set
         vector<bool> vertex_removed(n); // just a marker recording the vertices we have already searched
         for (ll i = 0; i < n; i++)
         {
+            if (time_limit > 0 && t.get_time() > time_limit)
+                break;
             ll enumerate_num = i + 1;
             ui u = seq[i];
             bool pruned;
@@ -672,18 +824,16 @@ public:
      *
      * @param rm mask of vertices that need to remove
      */
-    void remove_v(vector<bool> &rm, int lb)
+    void remove_v(vector<bool> &rm, int lb, GraphWorkspace &ws = GraphWorkspace::local())
     {
-        ui *q = new ui[n + 1];
+        ws.q.resize(n + 1);
+        ui *q = ws.q.data();
         ui hh = 1, tt = 0;
         for (ui i = 0; i < n; i++)
             if (rm[i])
                 q[++tt] = i;
         if (tt == 0)
-        {
-            delete[] q;
             return;
-        }
         while (hh <= tt)
         {
             ui u = q[hh++];
@@ -697,17 +847,15 @@ public:
             }
         }
         ui new_n = 0;
-        vector<ui> new_map(n);
         for (ui i = 0; i < n; i++)
             if (!rm[i])
             {
-                new_map[new_n] = map_refresh_id[i];
+                map_refresh_id[new_n] = map_refresh_id[i];
                 q[i] = new_n++;
             }
-        new_map.resize(new_n);
-        map_refresh_id = new_map;
-        ui *new_pstart = new ui[new_n + 1];
-        ui *new_d = new ui[new_n];
+        map_refresh_id.resize(new_n);
+        ui *new_pstart = ws.take(GraphWorkspace::PSTART, new_n + 1);
+        ui *new_d = ws.take(GraphWorkspace::DEGREE, new_n);
         ui j = 0;
         for (ui i = 0; i < n; i++)
         {
@@ -724,8 +872,8 @@ public:
             new_d[u] = j - new_pstart[u];
         }
         new_pstart[new_n] = j;
-        delete[] d;
-        delete[] pstart;
+        ws.give_back(GraphWorkspace::DEGREE, d, n);
+        ws.give_back(GraphWorkspace::PSTART, pstart, n + 1);
         d = new_d;
         pstart = new_pstart;
         if (j * 2 < m)
@@ -737,7 +885,6 @@ public:
         }
         m = j;
         n = new_n;
-        delete[] q;
     }
     /**
      * @brief stage-III: acquire a heuristic solution in the sqrt graph
@@ -964,25 +1111,251 @@ public:
         }
         return sqrt_degeneracy(range, neighbor, d, id, solution);
     }
+    /**
+     * @brief core[u] = the core number of u, which does not depend on k
+     * a vertex u with core[u]+k<=lb is in no k-plex larger than lb, for any k
+     */
+    vector<ui> get_core_numbers() const
+    {
+        vector<ui> core(n, 0);
+        if (n == 0)
+            return core;
+        vector<ui> deg(d, d + n);
+        vector<bool> rm(n);
+        LinearHeap heap(n, n, deg);
+        ui max_core = 0;
+        while (heap.sz)
+        {
+            ui u = heap.get_min_node();
+            heap.delete_node(u);
+            rm[u] = 1;
+            max_core = max(max_core, deg[u]);
+            core[u] = max_core;
+            for (ui i = pstart[u]; i < pstart[u + 1]; i++)
+            {
+                ui v = edge_to[i];
+                if (!rm[v])
+                    heap.decrease(--deg[v], v);
+            }
+        }
+        return core;
+    }
+    /**
+     * @brief the subgraph induced by {u | core[u]>=min_core}, i.e., the min_core-core
+     * the ids of the loaded graph are kept in map_refresh_id, so solutions of the subgraph need no translation
+     */
+    Graph induce_by_core(const vector<ui> &core, ui min_core, GraphWorkspace &ws = GraphWorkspace::local()) const
+    {
+        vector<int> ids;
+        vector<ui> &inv = ws.id_map;
+        inv.assign(n, n);
+        for (ui u = 0; u < n; u++)
+            if (core[u] >= min_core)
+            {
+                inv[u] = ids.size();
+                ids.push_back(map_refresh_id[u]);
+            }
+        vector<ui> sub_pstart(ids.size() + 1), sub_edge_to;
+        ui new_n = 0;
+        for (ui u = 0; u < n; u++)
+        {
+            if (inv[u] == n)
+                continue;
+            sub_pstart[new_n++] = sub_edge_to.size();
+            for (ui i = pstart[u]; i < pstart[u + 1]; i++)
+                if (inv[edge_to[i]] != n)
+                    sub_edge_to.push_back(inv[edge_to[i]]); // still in ascending order
+        }
+        sub_pstart[new_n] = sub_edge_to.size();
+        return Graph(ids, sub_pstart, sub_edge_to, ws);
+    }
+    /**
+     * @brief whether s is a k-plex, i.e., each u in s has at least |s|-k neighbors in s
+     */
+    bool is_plex(const set<ui> &s, int k) const
+    {
+        for (ui u : s)
+        {
+            if (u >= n)
+                return false;
+            ui cnt = 0;
+            for (ui i = pstart[u]; i < pstart[u + 1]; i++)
+                cnt += s.count(edge_to[i]);
+            if (cnt + k < s.size())
+                return false;
+        }
+        return true;
+    }
+    /**
+     * @brief the subgraph induced by the anchors and the vertices that can join them in a k-plex of size >= 2k-1:
+     * such a k-plex has diameter <= 2, so each vertex is within 2 hops of every anchor, and it has at most k-1
+     * non-neighbors among the anchors; the cost only depends on the 2-hop neighborhoods of the anchors
+     * the ids of the loaded graph are kept in map_refresh_id, like induce_by_core
+     * @return an empty graph if two anchors are more than 2 hops away
+     */
+    Graph induce_common_2hop(const set<ui> &anchors) const
+    {
+        struct Hit
+        {
+            int hop_cnt; // the number of anchors within 2 hops, i.e., hop_cnt=j means the first j anchors
+            int adj_cnt; // the number of adjacent anchors
+        };
+        vector<ui> order(anchors.begin(), anchors.end());
+        sort(order.begin(), order.end(), [&](ui a, ui b)
+             { return pstart[a + 1] - pstart[a] < pstart[b + 1] - pstart[b]; });
+        unordered_map<ui, Hit> hit; // only the 2-hop neighborhood of the anchor with min degree is kept
+        for (int j = 0; j < order.size(); j++)
+        {
+            ui a = order[j];
+            auto reach = [&](ui w)
+            {
+                auto it = hit.find(w);
+                if (it == hit.end())
+                {
+                    if (j == 0) // a common 2-hop neighbor is in the 2-hop neighborhood of the first anchor
+                        hit[w] = Hit{1, 0};
+                }
+                else if (it->y.hop_cnt == j) // reached by the j-th anchor for the first time
+                    it->y.hop_cnt++;
+            };
+            reach(a);
+            for (ui i = pstart[a]; i < pstart[a + 1]; i++)
+            {
+                ui u = edge_to[i];
+                reach(u);
+                auto it = hit.find(u);
+                if (it != hit.end())
+                    it->y.adj_cnt++;
+                for (ui l = pstart[u]; l < pstart[u + 1]; l++)
+                    reach(edge_to[l]);
+            }
+        }
+        int sz = order.size();
+        vector<ui> vertices;
+        int anchor_cnt = 0;
+        for (auto &h : hit)
+        {
+            if (h.y.hop_cnt < sz)
+                continue;
+            if (anchors.count(h.x))
+            {
+                anchor_cnt++;
+                vertices.push_back(h.x);
+            }
+            else if (sz - h.y.adj_cnt + 1 <= paramK) // h.x and its non-neighbors among the anchors
+                vertices.push_back(h.x);
+        }
+        if (anchor_cnt < sz) // an anchor is more than 2 hops away from another one
+            return Graph();
+        sort(vertices.begin(), vertices.end());
+        unordered_map<ui, ui> inv;
+        vector<int> ids;
+        for (ui u : vertices)
+        {
+            inv[u] = ids.size();
+            ids.push_back(map_refresh_id[u]);
+        }
+        vector<ui> sub_pstart(vertices.size() + 1), sub_edge_to;
+        for (ui i = 0; i < vertices.size(); i++)
+        {
+            ui u = vertices[i];
+            sub_pstart[i] = sub_edge_to.size();
+            for (ui l = pstart[u]; l < pstart[u + 1]; l++)
+            {
+                auto it = inv.find(edge_to[l]);
+                if (it != inv.end())
+                    sub_edge_to.push_back(it->y); // still in ascending order
+            }
+        }
+        sub_pstart[vertices.size()] = sub_edge_to.size();
+        return Graph(ids, sub_pstart, sub_edge_to);
+    }
+    /**
+     * @brief degeneracy order that keeps the anchors: the other vertex with min degree is removed until the rest is a
+     * k-plex, so the k-plex contains all the anchors (which should be a k-plex); it is done among the common
+     * neighbors of the anchors first, which usually gives a larger k-plex, and then among all the vertices
+     * @return the size of the larger k-plex; it is stored in solution if it is larger
+     */
+    int anchored_degeneracy(const set<ui> &anchors, set<ui> &solution)
+    {
+        vector<ui> anchor_list, adj_cnt(n); // adj_cnt[u] = the number of anchors adjacent to u
+        vector<bool> is_anchor(n);
+        for (ui u = 0; u < n; u++)
+            if (anchors.count(map_refresh_id[u]))
+            {
+                is_anchor[u] = 1;
+                anchor_list.push_back(u);
+                for (ui i = pstart[u]; i < pstart[u + 1]; i++)
+                    adj_cnt[edge_to[i]]++;
+            }
+        int ret = 0;
+        for (int round = 0; round < 2; round++)
+        {
+            vector<bool> rm(n);
+            ui rest = n;
+            for (ui u = 0; u < n; u++)
+                if (round == 0 && !is_anchor[u] && adj_cnt[u] < anchor_list.size())
+                    rm[u] = 1, rest--;
+            vector<ui> deg(n);
+            LinearHeap heap(n, n);
+            for (ui u = 0; u < n; u++)
+            {
+                if (rm[u])
+                    continue;
+                for (ui i = pstart[u]; i < pstart[u + 1]; i++)
+                    deg[u] += !rm[edge_to[i]];
+                if (!is_anchor[u])
+                    heap.insert(deg[u], u);
+            }
+            while (heap.sz)
+            {
+                ui min_deg = heap.get_min_key();
+                for (ui a : anchor_list)
+                    min_deg = min(min_deg, deg[a]);
+                if (min_deg + paramK >= rest)
+                    break;
+                ui u = heap.get_min_node();
+                heap.delete_node(u);
+                rm[u] = 1;
+                rest--;
+                for (ui i = pstart[u]; i < pstart[u + 1]; i++)
+                {
+                    ui v = edge_to[i];
+                    if (rm[v])
+                        continue;
+                    deg[v]--;
+                    if (!is_anchor[v])
+                        heap.decrease(deg[v], v);
+                }
+            }
+            if (rest > solution.size())
+            {
+                solution.clear();
+                for (ui u = 0; u < n; u++)
+                    if (!rm[u])
+                        solution.insert(map_refresh_id[u]);
+            }
+            ret = max(ret, (int)rest);
+        }
+        return ret;
+    }
     /**
      * @brief for u in G, is d[u]+k<=lb, remove u
      *
      * T(n)=O(n+m)
      * after reduction, the graph is re-built so that each vertex's id ∈[0, n-1], the map is stored in map_refresh_id
      */
-    void weak_reduce(int lb)
+    void weak_reduce(int lb, GraphWorkspace &ws = GraphWorkspace::local())
     {
-        ui *q = new ui[n + 1]; // queue
-        vector<bool> rm(n, 0); // rm[u]=1 <=> u is removed
-        ui hh = 1, tt = 0;     // used for queue
+        ws.q.resize(n + 1);
+        ui *q = ws.q.data(); // queue
+        vector<bool> rm(n);  // rm[u]=1 <=> u is removed
+        ui hh = 1, tt = 0;   // used for queue
         for (ui i = 0; i < n; i++)
             if (d[i] + paramK <= lb)
                 q[++tt] = i, rm[i] = 1;
         if (tt == 0) // q is empty
-        {
-            delete[] q;
             return;
-        }
         while (hh <= tt)
         {
             ui u = q[hh++];
@@ -997,17 +1370,15 @@ public:
         }
         // re-build the graph : re-map the id of the rest vertices; the array q[] is recycled to save the map
         ui new_n = 0;
-        vector<ui> new_map(n);
         for (ui i = 0; i < n; i++)
             if (!rm[i])
             {
-                new_map[new_n] = map_refresh_id[i];
+                map_refresh_id[new_n] = map_refresh_id[i];
                 q[i] = new_n++;
             }
-        new_map.resize(new_n);
-        map_refresh_id = new_map;
-        ui *new_pstart = new ui[new_n + 1];
-        ui *new_d = new ui[new_n];
+        map_refresh_id.resize(new_n);
+        ui *new_pstart = ws.take(GraphWorkspace::PSTART, new_n + 1);
+        ui *new_d = ws.take(GraphWorkspace::DEGREE, new_n);
         ui j = 0; // we don't need extra memory to store new-edge_to, just re-use edge_to[]
         for (ui i = 0; i < n; i++)
         {
@@ -1024,8 +1395,8 @@ public:
             new_d[u] = j - new_pstart[u];
         }
         new_pstart[new_n] = j;
-        delete[] d;
-        delete[] pstart;
+        ws.give_back(GraphWorkspace::DEGREE, d, n);
+        ws.give_back(GraphWorkspace::PSTART, pstart, n + 1);
         d = new_d;
         pstart = new_pstart;
         // you can ignore the following
@@ -1038,21 +1409,23 @@ public:
         }
         m = j;
         n = new_n;
-        delete[] q;
     }
     /**
      * @brief degenaracy order to get lb, i.e., each time we remove the vertex with min degree;
      * then we reduce the graph to (lb+1-k)-core
      *
      * @param solution if not NULL, the heuristic result should be stored
+     * @param raise_lb if false, the heuristic result does not raise lb, e.g., only the plexes containing the anchors
+     * matter; then the graph is only reduced with lb and rebuilt in degeneracy order
      *
      * @return lb
      *
      * T(n)=O(n+m) [actually, the code is O(n+mlogn)]
      */
-    int degeneracy_and_reduce(int lb, set<ui> *solution = nullptr)
+    int degeneracy_and_reduce(int lb, set<ui> *solution = nullptr, GraphWorkspace &ws = GraphWorkspace::local(),
+                              bool raise_lb = true)
     {
-        vector<bool> rm(n, 0); // rm[u]=1 <==> u is peeled and removed
+        vector<bool> rm(n); // rm[u]=1 <==> u is peeled and removed
         // weak reduce
         if (lb > paramK)
         {
@@ -1081,8 +1454,10 @@ public:
                 }
             }
         }
-        vector<ui> core(n, 0);
-        vector<ui> seq(n, n); // the reverse order of degeneracy order, i.e., v_0 is seq[n-1] while v_{n-1} is seq[0]
+        vector<ui> &core = ws.core;
+        core.assign(n, 0);
+        vector<ui> &seq = ws.seq; // the reverse order of degeneracy order, i.e., v_0 is seq[n-1] while v_{n-1} is seq[0]
+        seq.assign(n, n);
         vector<ui> plex;
         ui rest_v_cnt = 0;
         // compute degeneracy order
@@ -1130,7 +1505,8 @@ public:
                 max_core = max(max_core, pd[u]);
                 core[u] = max_core;
             }
-            lb = max(lb, rest);
+            if (raise_lb)
+                lb = max(lb, rest);
         }
         // store k-plex
         if (solution != nullptr && solution->size() < plex.size())
@@ -1154,8 +1530,10 @@ public:
             }
             seq.resize(new_n);
             reverse(seq.begin(), seq.end()); // now seq[] is degeneracy order, v_i is seq[i]
-            vector<ui> new_map(new_n);
-            vector<ui> q(n, n); // q[seq[u]]=u
+            vector<ui> &new_map = ws.id_map;
+            new_map.resize(new_n);
+            vector<ui> &q = ws.q; // q[seq[u]]=u
+            q.assign(n, n);
             ui most_edge_cnt = 0;
             for (ui i = 0; i < new_n; i++) // store the map of indices of vertices
             {
@@ -1165,10 +1543,10 @@ public:
                 ui deg = pstart[u + 1] - pstart[u];
                 most_edge_cnt += deg;
             }
-            map_refresh_id = new_map;
-            ui *new_edge_to = new ui[most_edge_cnt];
-            ui *new_pstart = new ui[new_n + 1];
-            ui *new_d = new ui[new_n];
+            map_refresh_id.assign(new_map.begin(), new_map.end());
+            ui *new_edge_to = ws.take(GraphWorkspace::EDGE, most_edge_cnt);
+            ui *new_pstart = ws.take(GraphWorkspace::PSTART, new_n + 1);
+            ui *new_d = ws.take(GraphWorkspace::DEGREE, new_n);
             ui new_m = 0;
             // rebuild graph
             for (ui u = 0; u < new_n; u++)
@@ -1187,9 +1565,9 @@ public:
                 sort(new_edge_to + new_pstart[u], new_edge_to + new_m);
             }
             new_pstart[new_n] = new_m;
-            delete[] pstart;
-            delete[] d;
-            delete[] edge_to;
+            ws.give_back(GraphWorkspace::PSTART, pstart, n + 1);
+            ws.give_back(GraphWorkspace::DEGREE, d, n);
+            ws.give_back(GraphWorkspace::EDGE, edge_to, m);
             d = new_d;
             pstart = new_pstart;
             edge_to = new_edge_to;
@@ -1206,8 +1584,7 @@ public:
         FILE *out = fopen(path.c_str(), "w");
         if (out == nullptr)
         {
-            printf("File open failed: %s\n", path.c_str());
-            exit(1);
+            throw runtime_error("File open failed: " + path);
         }
         if (!n)
             m = 0;
@@ -1233,6 +1610,11 @@ public:
     }
 };
 
+// the CSR of Graph_reduced_adjacent_list is compacted once at least 1/CSR_COMPACT_DEAD_DIV of its entries are dead
+#ifndef CSR_COMPACT_DEAD_DIV
+#define CSR_COMPACT_DEAD_DIV 2
+#endif
+
 /**
  * base class : can be implemented using adj-matrix or adj-list
  * @brief this is a base class representing the reduced graph which serves for IE (or DC)
@@ -1248,7 +1630,7 @@ public:
     int *d;                              // degree
     AdjacentMatrix A;
     // shared memory for CTCP
-    vector<bool> bool_array_n_n, bool_array_m, bool_array_n;
+    vector<bool> bool_array_n_n, bool_array_m, bool_array_n; // the flags are kept as bits
     int *pstart, *edge_to, *triangles_m;
     vector<bool> edge_removed;
     Graph_reduced() : d(nullptr), pstart(nullptr), edge_to(nullptr), triangles_m(nullptr)
@@ -1300,11 +1682,21 @@ public:
      */
     void remove_v(int v, int lb, bool lb_changed)
     {
-        CTCP(lb, v);
+        if (vertex[v]) // v may be removed already, e.g., by a CTCP(lb) in the background
+            CTCP(lb, v);
         if (lb_changed)
         {
             CTCP(lb);
         }
+        compact();
+    }
+    /**
+     * @brief exclude v whose g_i is pruned, so lb is not changed; the subclass may leave the triangle updates to
+     * the next CTCP, thus a run of pruned g_i shares one cascade
+     */
+    virtual void remove_v_lazily(int v, int lb)
+    {
+        remove_v(v, lb, false);
     }
     /**
      * @brief inspired by Lijun Chang
@@ -1313,6 +1705,12 @@ public:
     virtual void CTCP(int lb, int v = -1)
     {
     }
+    /**
+     * @brief drop the removed edges and vertices from the storage if too many of them are kept
+     */
+    virtual void compact()
+    {
+    }
     /**
      * given a vertex v, induce the 2-hop neighbor of v
      * @param vis stores the 2-hop neighbor of v
@@ -1330,7 +1728,7 @@ public:
      *
      * @return if this subgraph can be pruned, then we set vis[v]=0, i.e., vis.size()=0
      */
-    virtual void induce_to_2hop_and_reduce(int v, MyBitset &vis, vector<int> &vertices, vector<int> &deg, int lb)
+    virtual void induce_to_2hop_and_reduce(int v, MyBitset &vis, vector<int> &vertices, EpochArray<int> &deg, int lb)
     {
     }
     /**
@@ -1372,8 +1770,83 @@ public:
  */
 class Graph_reduced_adjacent_list : public Graph_reduced
 {
+    ll live_m; // the number of entries in edge_to[] whose edge and both endpoints are not removed
+    vector<int> lazily_removed; // the vertices removed by remove_v_lazily whose triangles are not updated yet
+
+    /**
+     * @brief remove u from the vertex set and the heap, and update the degrees of its neighbors;
+     * each neighbor v with d[v]+k<=lb is marked and handed to push(v)
+     */
+    template <typename Push>
+    void peel_vertex(int u, int lb, Push push)
+    {
+        vector<bool> &in_queue_e = bool_array_m;
+        vector<bool> &in_queue_v = bool_array_n;
+        for (ui i = pstart[u]; i < pstart[u + 1]; i++)
+        {
+            if (in_queue_e[i])
+                continue;
+            ui v = edge_to[i];
+            if (in_queue_v[v])
+            {
+                if (vertex[v]) // v is still in the queue, so (u,v) dies with u
+                    live_m -= 2;
+                continue;
+            }
+            live_m -= 2;
+            if (--d[v] + paramK <= lb)
+            {
+                in_queue_v[v] = 1;
+                push(v);
+            }
+            heap.decrease(d[v], v);
+        }
+        vertex.reset(u);
+        heap.delete_node(u);
+    }
+    /**
+     * @brief u is removed: decrease the triangle counts of the edges (v,w) with v,w in N(u), and push the edges
+     * that can be removed into q_edges
+     */
+    void remove_triangles_of(int u, int lb, queue<pii> &q_edges)
+    {
+        vector<bool> &in_queue_e = bool_array_m;
+        vector<bool> &in_queue_v = bool_array_n;
+        for (ui i = pstart[u]; i < pstart[u + 1]; i++)
+        {
+            if (in_queue_e[i])
+                continue;
+            int v = edge_to[i];
+            if (in_queue_v[v])
+                continue;
+            int *st = edge_to + pstart[v], *ed = edge_to + pstart[v + 1];
+            for (ui j = i + 1; j < pstart[u + 1]; j++)
+            {
+                if (in_queue_e[j])
+                    continue;
+                int w = edge_to[j]; // v w are neighbors of u
+                if (in_queue_v[w])
+                    continue;
+                if (has(st, ed, w)) // v is connected to w
+                {
+                    ui id_vw = find(st, ed, w) + pstart[v];
+                    if (in_queue_e[id_vw])
+                        continue;
+                    ui id_wv = find(edge_to + pstart[w], edge_to + pstart[w + 1], v) + pstart[w];
+                    --triangles_m[id_wv];
+                    --triangles_m[id_vw];
+                    if (triangles_m[id_vw] + 2 * paramK <= lb)
+                    {
+                        in_queue_e[id_vw] = 1, in_queue_e[id_wv] = 1;
+                        q_edges.push({id_vw, v});
+                    }
+                }
+            }
+        }
+    }
+
 public:
-    Graph_reduced_adjacent_list() : Graph_reduced() {}
+    Graph_reduced_adjacent_list() : Graph_reduced(), live_m(0) {}
     /**
      * init graph after stage-I(preprocessing)
      * @param g reduced graph
@@ -1382,7 +1855,7 @@ public:
     Graph_reduced_adjacent_list(Graph &g) : Graph_reduced()
     {
         n = g.n;
-        m = g.m;
+        m = live_m = g.m;
         edge_removed.resize(m);
         printf("reduced graph n= %d m= %d lb= %d\n", n, m / 2, lb);
         pstart = new int[n + 1];
@@ -1506,7 +1979,7 @@ public:
                     {
                         if (u < v)
                             q_edges.push({i, u});
-                        in_queue_e[i] = true;
+                        in_queue_e[i] = 1;
                     }
                 }
                 if (d[u] + paramK <= lb)
@@ -1521,6 +1994,10 @@ public:
             q_vertex.push(v);
             in_queue_v[v] = 1;
         }
+        // the vertices removed lazily are already peeled, but the triangles containing them are still counted
+        for (int u : lazily_removed)
+            remove_triangles_of(u, lb, q_edges);
+        lazily_removed.clear();
         while (q_edges.size() || q_vertex.size())
         {
             while (q_edges.size())
@@ -1531,6 +2008,7 @@ public:
                 edge_removed[edge_id] = 1;
                 int another_edge_id = find(edge_to + pstart[v], edge_to + pstart[v + 1], u) + pstart[v];
                 edge_removed[another_edge_id] = 1;
+                live_m -= 2;
                 if (--d[u] + paramK <= lb && !in_queue_v[u])
                 {
                     q_vertex.push(u);
@@ -1572,7 +2050,7 @@ public:
                             --triangles_m[id_wu];
                             if (triangles_m[id_uw] + paramK * 2 <= lb)
                             {
-                                in_queue_e[id_uw] = in_queue_e[id_wu] = 1;
+                                in_queue_e[id_uw] = 1, in_queue_e[id_wu] = 1;
                                 q_edges.push({id_uw, u});
                             }
                         }
@@ -1585,7 +2063,7 @@ public:
                             --triangles_m[id_wv];
                             if (triangles_m[id_vw] + paramK * 2 <= lb)
                             {
-                                in_queue_e[id_vw] = in_queue_e[id_wv] = 1;
+                                in_queue_e[id_vw] = 1, in_queue_e[id_wv] = 1;
                                 q_edges.push({id_vw, v});
                             }
                         }
@@ -1602,56 +2080,58 @@ public:
             {
                 ui u = q_vertex.front();
                 q_vertex.pop();
-                for (ui i = pstart[u]; i < pstart[u + 1]; i++)
-                {
-                    if (in_queue_e[i])
-                        continue;
-                    ui v = edge_to[i];
-                    if (in_queue_v[v])
-                        continue;
-                    if (--d[v] + paramK <= lb)
-                    {
-                        in_queue_v[v] = 1;
-                        q_vertex.push(v);
-                    }
-                    heap.decrease(d[v], v);
-                }
+                peel_vertex(u, lb, [&q_vertex](int v)
+                            { q_vertex.push(v); });
                 // update the triangles containing u
-                for (ui i = pstart[u]; i < pstart[u + 1]; i++)
-                {
-                    if (in_queue_e[i])
-                        continue;
-                    int v = edge_to[i];
-                    if (in_queue_v[v])
-                        continue;
-                    int *st = edge_to + pstart[v], *ed = edge_to + pstart[v + 1];
-                    for (ui j = i + 1; j < pstart[u + 1]; j++)
-                    {
-                        if (in_queue_e[j])
-                            continue;
-                        int w = edge_to[j]; // v w are neighbors of u
-                        if (in_queue_v[w])
-                            continue;
-                        if (has(st, ed, w)) // v is connected to w
-                        {
-                            ui id_vw = find(st, ed, w) + pstart[v];
-                            if (in_queue_e[id_vw])
-                                continue;
-                            ui id_wv = find(edge_to + pstart[w], edge_to + pstart[w + 1], v) + pstart[w];
-                            --triangles_m[id_wv];
-                            --triangles_m[id_vw];
-                            if (triangles_m[id_vw] + 2 * paramK <= lb)
-                            {
-                                in_queue_e[id_vw] = in_queue_e[id_wv] = 1;
-                                q_edges.push({id_vw, v});
-                            }
-                        }
-                    }
-                }
-                vertex.reset(u);
-                heap.delete_node(u);
+                remove_triangles_of(u, lb, q_edges);
+            }
+        }
+    }
+    /**
+     * @brief exclude v whose g_i is pruned: v and the vertices with d+k<=lb after it are peeled now, and the
+     * triangle counts are updated by the next CTCP; a stale count is never smaller than the real one, so the
+     * edges kept in the meantime only make the next g_i larger
+     */
+    void remove_v_lazily(int v, int lb)
+    {
+        vector<bool> &in_queue_v = bool_array_n;
+        size_t head = lazily_removed.size();
+        lazily_removed.push_back(v);
+        in_queue_v[v] = 1;
+        while (head < lazily_removed.size())
+            peel_vertex(lazily_removed[head++], lb, [this](int w)
+                        { lazily_removed.push_back(w); });
+    }
+    /**
+     * @brief once at least 1/CSR_COMPACT_DEAD_DIV of edge_to[] is dead, rebuild the CSR in place with only the live
+     * entries, so that the scans of IE cost O(live graph); the ids of vertices are kept and a removed vertex just
+     * gets an empty neighbor list, thus the heap and the arrays indexed by vertex are still valid
+     */
+    void compact()
+    {
+        if ((m - live_m) * CSR_COMPACT_DEAD_DIV < m)
+            return;
+        int new_m = 0;
+        for (int u = 0; u < n; u++)
+        {
+            int st = pstart[u], ed = pstart[u + 1];
+            pstart[u] = new_m;
+            if (!vertex[u])
+                continue;
+            for (int i = st; i < ed; i++)
+            {
+                if (edge_removed[i] || !vertex[edge_to[i]])
+                    continue;
+                edge_to[new_m] = edge_to[i];
+                triangles_m[new_m] = triangles_m[i];
+                new_m++;
             }
         }
+        pstart[n] = new_m;
+        assert(new_m == live_m);
+        m = new_m;
+        edge_removed.assign(m, 0);
+        bool_array_m.assign(m, 0); // no edge is in the queue now
     }
     /**
      * given a vertex v, induce the 2-hop neighbor of v
@@ -1696,9 +2176,10 @@ public:
      *
      * @return if this subgraph can be pruned, then we set vis[v]=0, i.e., vis.size()=0
      */
-    void induce_to_2hop_and_reduce(int v, MyBitset &vis, vector<int> &vertices, vector<int> &deg, int lb)
+    void induce_to_2hop_and_reduce(int v, MyBitset &vis, vector<int> &vertices, EpochArray<int> &deg, int lb)
     {
         vis.reset(v);
+        deg.clear();
         // get G[N(v)] and compute degree
         for (int i = pstart[v]; i < pstart[v + 1]; i++)
         {
@@ -1737,7 +2218,6 @@ public:
             {
                 for (int u : vertices) // clear the arrays
                 {
-                    deg[u] = 0;
                     if (vis[u])
                         vis.reset(u);
                 }
@@ -1768,9 +2248,9 @@ public:
                 {
                     vertices[++cnt] = u;
                 }
-                deg[u] = 0; // clear deg[]
             }
             vertices.resize(cnt + 1);
+            deg.clear();
             if (cnt < lb + 1 - paramK) // current subgraph can be pruned
             {
                 // clear the vis[]
@@ -1804,7 +2284,6 @@ public:
             for (int i = 1; i <= cnt; i++)
             {
                 int a = vertices[i];
-                neighbor_cnt[a] = 0;
                 for (int j = pstart[a]; j < pstart[a + 1]; j++)
                 {
                     int b = edge_to[j];
@@ -1813,7 +2292,6 @@ public:
                         vis.set(b);
                         vertices.push_back(b);
                     }
-                    neighbor_cnt[b] = 0;
                 }
             }
         }
@@ -1828,6 +2306,7 @@ public:
         else
         {
             // reduce g_i to a (lb+1-k)-core
+            deg.clear();
             for (int a : vertices)
             {
                 for (int j = pstart[a]; j < pstart[a + 1]; j++)
@@ -1854,7 +2333,6 @@ public:
             {
                 int a = q.front();
                 q.pop();
-                deg[a] = 0;
                 for (int j = pstart[a]; j < pstart[a + 1]; j++)
                 {
                     int b = edge_to[j];
@@ -1871,7 +2349,7 @@ public:
             for (int a : vertices)
             {
                 if (vis[a])
-                    vertices[cnt++] = a, deg[a] = 0;
+                    vertices[cnt++] = a;
             }
             vertices.resize(cnt);
             if (!vis[v] || cnt <= lb)
@@ -2131,7 +2609,7 @@ public:
      *
      * @return if this subgraph can be pruned, then we set vis[v]=0, i.e., vis.size()=0
      */
-    void induce_to_2hop_and_reduce(int v, MyBitset &vis, vector<int> &vertices, vector<int> &deg, int lb)
+    void induce_to_2hop_and_reduce(int v, MyBitset &vis, vector<int> &vertices, EpochArray<int> &deg, int lb)
     {
         vis |= A[v];
         vis.reset(v);
@@ -2164,8 +2642,7 @@ public:
             }
         }
         // now vis stores the rest of N(v)+v
-        for (int &x : deg) // clear deg[]
-            x = 0;
+        deg.clear();
         if (vis.size() < lb + 1 - paramK) // current subgraph can be pruned
         {
             vis.clear();
@@ -2188,6 +2665,11 @@ public:
     }
 };
 
+// the cache budget (in bytes) of the tiled pass in Graph_adjacent::edge_reduction
+#ifndef EDGE_REDUCTION_TILE_BYTES
+#define EDGE_REDUCTION_TILE_BYTES (1 << 18)
+#endif
+
 /**
  * used for bnb, i.e., each 2-hop induced subgraph is stored using adjacent matrix
  */
@@ -2197,8 +2679,12 @@ public:
     double init_time; // used for log
     AdjacentMatrix adj_matrix;
     int n;
+    ll m;                  // the number of edges, kept up to date by the constructors and edge_reduction
     vector<int> vertex_id; // for u in this, vertex_id[u] in G_reduced
-    Graph_adjacent() : init_time(0) {}
+    // if second_order_lb==lb, then each edge has |N(u)∩N(v)|+2k>lb and each vertex has d(u)+k>lb,
+    // e.g., g_i is copied from a graph reduced by CF-CTCP, so the second-order reduction removes nothing
+    int second_order_lb;
+    Graph_adjacent() : init_time(0), n(0), m(0), second_order_lb(-1) {}
     /**
      * @brief given vertex set V_mask, induce subgraph
      *
@@ -2207,7 +2693,7 @@ public:
      * @param g reduced graph which use adj-list to store edges
      * @param inv each vertex in subgraph is [0, n-1], so we need to save the origin index
      */
-    Graph_adjacent(MyBitset &V_mask, vector<int> &vertices, Graph_reduced &g, vector<int> &inv)
+    Graph_adjacent(MyBitset &V_mask, vector<int> &vertices, Graph_reduced &g, vector<int> &inv) : m(0), second_order_lb(-1)
     {
         if (g.is_matrix())
         {
@@ -2236,12 +2722,13 @@ public:
                     if (!V_mask[v])
                         continue;
                     adj_matrix.add_edge(inv[u], inv[v]);
+                    m++;
                 }
             }
             init_time = t.get_time();
         }
     }
-    Graph_adjacent(vector<int> &vertices, vector<pii> &edges)
+    Graph_adjacent(vector<int> &vertices, vector<pii> &edges) : m(0), second_order_lb(-1)
     {
         vertex_id = vertices;
         Timer t;
@@ -2250,7 +2737,7 @@ public:
         for (auto &h : edges)
         {
             if (h.x < h.y)
-                adj_matrix.add_edge(h.x, h.y);
+                adj_matrix.add_edge(h.x, h.y), m++;
         }
         init_time = t.get_time();
     }
@@ -2260,83 +2747,161 @@ public:
             return *this;
         init_time = other.init_time;
         adj_matrix = other.adj_matrix;
+        second_order_lb = other.second_order_lb;
         n = other.n;
+        m = other.m;
         vertex_id = other.vertex_id;
         return *this;
     }
     /**
      * @brief reduce edges: second & higher order reduction
+     * each pass only re-examines the edges incident to the rows changed since the last pass of the same rule
      */
+    template <int K>
     void edge_reduction(int v_in_S, int lb)
     {
-        // if(paramK <= 5)
-        //     return;
+        const int paramK = ParamK<K>::get();
         auto &A = adj_matrix;
-        bool reduced = false;
-        do
+        // changed[u]=1 <==> A[u] is changed since the last pass of second-order reduction
+        // changed_high[u]=1 <==> A[u] is changed since the last pass of higher-order reduction
+        MyBitset changed(n), changed_high(n), dirty(n);
+        if (second_order_lb != lb) // otherwise, the triangle counts of CF-CTCP show that no edge is removable now
+            changed.flip();
+#ifndef NDEBUG
+        else
         {
-            reduced = false;
             for (int u = 0; u < n; u++)
             {
+                assert(A[u].size() + paramK > lb);
                 for (int v : A[u])
-                {
-                    if (v >= u)
-                        break;
-                    int common_neighbor_cnt = A[u].intersect(A[v]);
-                    if (common_neighbor_cnt + 2 * paramK <= lb)
-                    {
-                        A[u].reset(v);
-                        A[v].reset(u);
-                        reduced = true;
-                    }
-                }
-                int deg = A[u].size();
-                if (deg + paramK <= lb && deg > 0)
-                {
-                    for (int v : A[u])
-                    {
-                        A[v].reset(u);
-                    }
-                    A[u].clear();
-                    reduced = true;
-                }
+                    assert(A[u].intersect(A[v]) + 2 * paramK > lb);
             }
+        }
+#endif
+        changed_high.flip();
+        bool reduced = false;
+        do
+        {
+            dirty = changed;
+            changed.clear();
+            reduced = edge_reduction_pass<K>(dirty, changed, changed_high, lb, [&A, lb, paramK](int u, int v)
+                                          { return A[u].intersect(A[v]) + 2 * paramK <= lb; });
             if (reduced || paramK == 2)
             {
                 continue;
             }
+            dirty = changed_high;
+            changed_high.clear();
+            if (dirty[v_in_S]) // N(v_in_S) is changed, so each edge needs to be re-examined
+            {
+                dirty.clear();
+                dirty.flip();
+            }
             auto &N_v = A[v_in_S];
+            reduced = edge_reduction_pass<K>(dirty, changed, changed_high, lb, [&A, &N_v, v_in_S, lb, paramK](int u, int v)
+                                          {
+                                              if (u == v_in_S || v == v_in_S)
+                                                  return false;
+                                              int common_neighbor_cnt = N_v.intersect(A[u], A[v]); // common neighbors of {u,v,v_in_S}
+                                              int loss_cnt = (!N_v[u]) + (!N_v[v]);
+                                              return common_neighbor_cnt + 3 * paramK - 2 * loss_cnt <= lb; });
+        } while (reduced);
+    }
+    /**
+     * @brief one pass of edge_reduction: for each edge (u,v) with u or v in dirty, remove it if removable(u,v);
+     * then remove u if d(u)+k<=lb; the changed rows are recorded in changed[] and changed_high[]
+     * if all rows are dirty and the matrix is larger than EDGE_REDUCTION_TILE_BYTES, we visit edges block by block
+     *
+     * @return whether any edge is removed
+     */
+    template <int K, typename Func>
+    bool edge_reduction_pass(MyBitset &dirty, MyBitset &changed, MyBitset &changed_high, int lb, Func removable)
+    {
+        auto &A = adj_matrix;
+        bool reduced = false;
+        int row_bytes = (A[0].n + 1) * sizeof(uint64_t);
+        int block = (EDGE_REDUCTION_TILE_BYTES / 2 / row_bytes) & ~63; // rows of a block, which is a multiple of 64
+        bool all_dirty = dirty.size() == n;
+        if (all_dirty && block > 0 && block < n)
+        {
+            // the rows of two blocks stay in cache when we visit edges from block bu to block bv
+            for (int bu = 0; bu < n; bu += block)
+                for (int bv = 0; bv <= bu; bv += block)
+                    for (int u = bu; u < n && u < bu + block; u++)
+                    {
+                        int end = min(bv + block, u); // v in [bv, end)
+                        for (int i = bv >> 6; (i << 6) < end; i++)
+                        {
+                            uint64_t word = A[u].buf[i];
+                            while (word)
+                            {
+                                int v = (i << 6) + __builtin_ctzll(word);
+                                word &= word - 1;
+                                if (v >= end)
+                                    break;
+                                if (removable(u, v))
+                                {
+                                    remove_edge_and_mark(u, v, changed, changed_high);
+                                    reduced = true;
+                                }
+                            }
+                        }
+                    }
             for (int u = 0; u < n; u++)
+                reduced |= remove_low_degree_vertex<K>(u, lb, changed, changed_high);
+            return reduced;
+        }
+        for (int u : dirty)
+        {
+            for (int v : A[u])
             {
-                if (u == v_in_S)
-                    continue;
-                for (int v : A[u])
+                if (v > u)
                 {
-                    if (v == v_in_S)
-                        continue;
-                    if (v >= u)
+                    if (all_dirty)
                         break;
-                    int common_neighbor_cnt = N_v.intersect(A[u], A[v]); // common neighbors of {u,v,v_in_S}
-                    int loss_cnt = (!A[v_in_S][u]) + (!A[v_in_S][v]);
-                    if (common_neighbor_cnt + 3 * paramK - 2 * loss_cnt <= lb)
-                    {
-                        A[u].reset(v);
-                        A[v].reset(u);
-                        reduced = true;
-                    }
+                    if (dirty[v]) // (u,v) will be examined when we visit v
+                        continue;
                 }
-                int deg = A[u].size();
-                if (deg + paramK <= lb && deg > 0)
+                if (removable(u, v))
                 {
-                    for (int v : A[u])
-                    {
-                        A[v].reset(u);
-                    }
-                    A[u].clear();
+                    remove_edge_and_mark(u, v, changed, changed_high);
                     reduced = true;
                 }
             }
-        } while (reduced);
+            reduced |= remove_low_degree_vertex<K>(u, lb, changed, changed_high);
+        }
+        return reduced;
+    }
+    /**
+     * @brief remove (u,v) from the matrix and mark the two rows as changed
+     */
+    inline void remove_edge_and_mark(int u, int v, MyBitset &changed, MyBitset &changed_high)
+    {
+        adj_matrix.remove_edge(u, v);
+        m--;
+        for (int w : {u, v})
+        {
+            if (!changed[w])
+                changed.set(w);
+            if (!changed_high[w])
+                changed_high.set(w);
+        }
+    }
+    /**
+     * @brief if d(u)+k<=lb, then we remove all edges of u
+     * @return whether u is removed
+     */
+    template <int K>
+    bool remove_low_degree_vertex(int u, int lb, MyBitset &changed, MyBitset &changed_high)
+    {
+        const int paramK = ParamK<K>::get();
+        auto &A = adj_matrix;
+        int deg = A[u].size();
+        if (deg + paramK > lb || deg == 0)
+            return false;
+        for (int v : A[u])
+            remove_edge_and_mark(u, v, changed, changed_high);
+        return true;
     }
     /**
      * @brief given vertex set V_mask, induce subgraph
@@ -2367,10 +2932,38 @@ public:
                 if (v >= u)
                     break;
                 adj_matrix.add_edge(inv[u], inv[v]);
+                m++;
             }
         }
         init_time = get_system_time_microsecond() - start_init;
     }
+    /**
+     * @brief build the matrix from a graph stored in CSR, i.e., the neighbors of u are edge_to[pstart[u], pstart[u+1])
+     * each edge occurs twice in CSR, so we only set one bit for each occurrence
+     */
+    void init_from_CSR(vector<int> &vertices, const ui *pstart, const ui *edge_to)
+    {
+        Timer t;
+        second_order_lb = -1;
+        vertex_id = vertices;
+        n = vertex_id.size();
+        adj_matrix = AdjacentMatrix(n);
+        for (int u = 0; u < n; u++)
+        {
+            auto &row = adj_matrix[u];
+            for (ui i = pstart[u]; i < pstart[u + 1]; i++)
+                row.set(edge_to[i]);
+        }
+        m = pstart[n] / 2;
+        init_time = t.get_time();
+    }
+    /**
+     * @brief m/(n(n-1)/2), from the edge count instead of a scan of the matrix
+     */
+    double density() const
+    {
+        return n > 1 ? 2.0 * m / ((double)n * (n - 1)) : 0;
+    }
     /**
      * useless, just a demo
      */
@@ -0,0 +1,512 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "Graph.h"
+#include "Branch.h"
+
+#ifdef enable_CTCP // the existing heuristic method Degen uses CTCP
+#include "2th-Reduction-CTCP.h"
+#else // use CF-CTCP
+#include "2th-Reduction.h"
+#endif
+
+/**
+ * @brief the statistics of one query, all times are in microseconds
+ */
+struct SolverStats
+{
+    double total_time;
+    double heuris_time; // KPHeuris, i.e., heuristic and preprocess
+    double FastHeuris_time;
+    double StrongHeuris_time;
+    double strong_reduce_time;
+    double list_triangle_time;
+    double bnb_time;
+    int FastHeuris_lb;
+    int heuris_lb;
+    bool solved_by_heuris; // the heuristic solution is the ground truth, so BRB_Rec is skipped
+    bool timed_out;        // solve() stopped at the time limit, so the solution may be not maximum
+    ll dfs_cnt;
+
+    SolverStats() : total_time(0), heuris_time(0), FastHeuris_time(0), StrongHeuris_time(0), strong_reduce_time(0),
+                    list_triangle_time(0), bnb_time(0), FastHeuris_lb(0), heuris_lb(0), solved_by_heuris(false),
+                    timed_out(false), dfs_cnt(0) {}
+};
+
+/**
+ * @brief a query of maximum k-plex on a loaded graph: graph and k in, solution and stats out
+ * the input graph is not modified, so it can be shared by many solvers; each solve() works on its own copy
+ * solve() runs on the calling thread and binds the thread-local paramK/lb to this query, so concurrent queries
+ * need one thread (and one Solver) each
+ */
+class Solver
+{
+    const Graph &input;
+    const vector<ui> *core; // the core numbers of input, shared by the solvers of a sweep over k
+    set<ui> seed;           // a known k-plex of input, e.g., the solution for k-1
+    set<ui> anchors;        // the vertices that the k-plex must contain; empty means the whole graph is searched
+    Graph g;
+    int k;
+    double time_budget; // the time limit of solve(), 0 means no limit
+    int target;         // decision mode: solve() stops at the first k-plex of at least target vertices; 0 means off
+#ifdef PIPELINE_IE
+    bool pipelined; // BRB_Rec uses a second thread to build the subgraphs, see Branch::pipelined_IE
+#endif
+    double algorithm_start_time;
+
+    /**
+     * @return the time when solve() should stop, 0 means never
+     */
+    double get_deadline()
+    {
+        return time_budget > 0 ? algorithm_start_time + time_budget : 0;
+    }
+
+    /**
+     * @brief whether the deadline is passed; if so, stats.timed_out is set and the rest of solve() is skipped
+     * the preprocessing passes are not interrupted, so it is checked between them
+     */
+    bool past_deadline()
+    {
+        if (!stats.timed_out && get_deadline() > 0 && get_system_time_microsecond() > get_deadline())
+            stats.timed_out = true;
+        return stats.timed_out;
+    }
+
+    /**
+     * @brief the heuristic stage without StrongHeuris
+     * @return whether the heuristic solution is the ground truth
+     */
+    bool FastHeuris()
+    {
+        Timer t("FastHeuris");
+        if (g.n <= lb || is_target_reached()) // the seed is maximum among the vertices left by induce_by_core, or answers the query
+        {
+            lb = max(lb, 2 * paramK - 2);
+            g.n = 0;
+            stats.FastHeuris_lb = lb;
+            stats.FastHeuris_time = t.get_time();
+            return true;
+        }
+        // degeneracy + weak reduce
+        {
+#ifndef NO_SQRT
+            lb = max(lb, g.sqrt_degeneracy(&solution));
+            printf("sqrt lb= %d, use time %.4lf s\n", lb, t.get_time() / 1e6);
+#endif
+            lb = max(lb, 2 * paramK - 2); // we only care the solutions with at least 2k-1 vertices
+            lb = max(lb, g.degeneracy_and_reduce(lb, &solution));
+            printf("After degeneracy and weak reduce, n= %u , m= %u , lb= %d , use time %.4lf s\n", g.n, g.m / 2, lb, t.get_time() / 1e6);
+            if (lb >= g.n || is_target_reached() || past_deadline())
+            {
+                g.n = 0;
+                stats.FastHeuris_lb = lb;
+                stats.FastHeuris_time = t.get_time();
+                return true;
+            }
+        }
+        stats.FastHeuris_lb = lb;
+
+        // strong reduce: CF-CTCP
+        {
+            Timer start_strong_reduce;
+            Reduction reduce(&g);
+            reduce.strong_reduce(lb);
+            printf("Afer strong reduce, n= %u , m= %u, use time %.4lf s\n", g.n, g.m / 2, start_strong_reduce.get_time() / 1e6);
+            stats.strong_reduce_time += start_strong_reduce.get_time();
+
+            if (lb >= g.n)
+            {
+                g.n = 0;
+                stats.FastHeuris_time = t.get_time();
+                return true;
+            }
+        }
+        stats.FastHeuris_time = t.get_time();
+        return false;
+    }
+
+    /**
+     * @brief we make more efforts to get better lb and then reduce graph
+     * @return whether the heuristic solution is the ground truth
+     */
+    bool StrongHeuris()
+    {
+        int iteration_cnt = 1;
+        double time_limit = 0; // 0 means no limit, i.e., StrongHeuris stops only when it finds no larger plex
+        if (get_deadline() > 0) // StrongHeuris only improves lb, it should not use up the budget of BRB_Rec
+            time_limit = max(1.0, (get_deadline() - get_system_time_microsecond()) / 2);
+        Timer t_extend("StrongHeuris");
+        while (1)
+        {
+#ifdef NO_STRONG_HEURIS
+            break;
+#endif
+            int extend_lb = 0;
+            if (solution.size() < 2 * paramK - 2) // this means we probably find no larger plex
+            {
+                break;
+            }
+            if (past_deadline() || (time_limit > 0 && t_extend.get_time() >= time_limit))
+                break;
+            extend_lb = g.strong_heuris(lb, solution, time_limit > 0 ? time_limit - t_extend.get_time() : 0);
+            printf("%dth-StrongHeuris lb= %d\n", iteration_cnt++, extend_lb);
+            if (extend_lb <= lb)
+                break;
+            lb = extend_lb;
+            if (is_target_reached())
+            {
+                g.n = 0;
+                stats.StrongHeuris_time = t_extend.get_time();
+                return true;
+            }
+            g.weak_reduce(lb);
+            if (past_deadline())
+                break;
+
+            // strong reduce
+            {
+                Timer start_strong_reduce;
+                Reduction reduce(&g);
+                reduce.strong_reduce(lb);
+                printf("Afer strong reduce, n= %u , m= %u, use time %.4lf s\n", g.n, g.m / 2, start_strong_reduce.get_time() / 1e6);
+                stats.strong_reduce_time += start_strong_reduce.get_time();
+
+                if (lb >= g.n)
+                {
+                    g.n = 0;
+                    stats.StrongHeuris_time = t_extend.get_time();
+                    return true;
+                }
+            }
+        }
+        stats.StrongHeuris_time = t_extend.get_time();
+        return false;
+    }
+
+    /**
+     * @brief the newly proprosed heuris in kPlexT
+     * @return whether the heuristic solution is the ground truth
+     */
+    bool EgoHeuris()
+    {
+        Timer t("ego-degen");
+        lb = max(lb, g.ego_degen(&solution));
+        if (is_target_reached())
+        {
+            g.n = 0;
+            return true;
+        }
+        g.weak_reduce(lb);
+        t.print_time();
+        if (past_deadline())
+            return true;
+        // strong reduce
+        {
+            Timer start_strong_reduce;
+            Reduction reduce(&g);
+            reduce.strong_reduce(lb);
+            printf("Afer strong reduce, n= %u , m= %u, use time %.4lf s\n", g.n, g.m / 2, start_strong_reduce.get_time() / 1e6);
+            stats.strong_reduce_time += start_strong_reduce.get_time();
+            if (lb >= g.n)
+            {
+                g.n = 0;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief stage-I: we conduct heuristic and preprocessing stage
+     * i.e., KPHeuris
+     * @return whether the heuristic solution is the ground truth
+     */
+    bool heuris()
+    {
+#ifdef EGO
+        return EgoHeuris();
+#endif
+        return FastHeuris() || StrongHeuris(); // generate n subgraphs and compute larger lb
+    }
+
+    void print_heuris_log()
+    {
+        puts("*************Heuristic result*************");
+        stats.heuris_time = get_system_time_microsecond() - algorithm_start_time;
+        printf("list triangles time: %.4lf s, strong reduce time: %.4lf s\n", list_triangle_time / 1e6, stats.strong_reduce_time / 1e6);
+        printf("total-heuristic-time= %.4lf s, FastHeuris-time= %.4lf s, StrongHeuris-time= %.4lf s\n",
+               stats.heuris_time / 1e6, stats.FastHeuris_time / 1e6, stats.StrongHeuris_time / 1e6);
+        printf("lb= %d , FastHeuris-lb= %d \n", lb, stats.FastHeuris_lb);
+        if (solution.size() >= max(2 * paramK - 1, target)) // in decision mode, lb starts from target-1
+            assert(solution.size() == lb);
+        if (is_target_reached())
+            printf("The heuristic solution reaches the target size %d!\n", target);
+        else if (stats.timed_out)
+            printf("The time limit is reached before BRB_Rec!\n");
+        else if (stats.solved_by_heuris)
+            printf("The heuristic solution is the ground truth!\n");
+    }
+
+    /**
+     * @brief branch and bound searching with Branch<K>, see bnb()
+     */
+    template <int K>
+    void bnb_with_k(Graph_reduced &G)
+    {
+        Branch<K> branch(G, lb, get_deadline());
+#ifdef PIPELINE_IE
+        branch.set_pipelined(pipelined);
+#endif
+        branch.set_target(target);
+        if (anchors.size())
+        {
+            vector<int> anchor_ids; // the anchors in g, which has the same ids as G
+            for (ui u = 0; u < g.n; u++)
+                if (anchors.count(g.map_refresh_id[u]))
+                    anchor_ids.push_back(u);
+            branch.anchored_search(anchor_ids);
+        }
+        else
+            branch.IE_framework();                    // generate n subgraphs
+        if (solution.size() < branch.solution.size()) // record the max plex
+        {
+            solution.clear();
+            for (int v : branch.solution)
+                solution.insert(v);
+        }
+        stats.dfs_cnt = branch.get_dfs_cnt();
+        stats.timed_out = branch.is_timed_out();
+    }
+
+    /**
+     * @brief branch and bound searching
+     * the common k are dispatched to a Branch specialized on k; otherwise (or if NO_K_SPECIALIZATION) we use the generic one
+     */
+    void bnb()
+    {
+        Graph_reduced_adjacent_list G(g);
+#ifndef NO_K_SPECIALIZATION
+        switch (paramK)
+        {
+        case 2:
+            return bnb_with_k<2>(G);
+        case 3:
+            return bnb_with_k<3>(G);
+        case 4:
+            return bnb_with_k<4>(G);
+        case 5:
+            return bnb_with_k<5>(G);
+        case 6:
+            return bnb_with_k<6>(G);
+        case 7:
+            return bnb_with_k<7>(G);
+        case 8:
+            return bnb_with_k<8>(G);
+        case 9:
+            return bnb_with_k<9>(G);
+        case 10:
+            return bnb_with_k<10>(G);
+        case 15:
+            return bnb_with_k<15>(G);
+        case 20:
+            return bnb_with_k<20>(G);
+        }
+#endif // NO_K_SPECIALIZATION
+        bnb_with_k<0>(G);
+    }
+
+    /**
+     * @brief the maximum k-plex that contains all the anchors: only their common 2-hop neighborhood is reduced and
+     * searched, so the cost depends on the neighborhood instead of the whole graph
+     */
+    void anchored_search()
+    {
+        if (!input.is_plex(anchors, paramK)) // so does any set containing the anchors
+        {
+            solution.clear();
+            return;
+        }
+        if (!includes(solution.begin(), solution.end(), anchors.begin(), anchors.end()))
+            solution = anchors;
+        lb = max((int)solution.size(), 2 * paramK - 2); // the common 2-hop neighborhood only holds the plexes >= 2k-1
+        if (target > 0)
+            lb = max(lb, target - 1);
+        if (is_target_reached())
+            return;
+
+        Timer t("anchored reduce");
+        g = input.induce_common_2hop(anchors);
+        printf("common 2-hop neighborhood of %d anchors: n= %u , m= %u\n", (int)anchors.size(), g.n, g.m / 2);
+        if (g.n > lb && !past_deadline())
+        {
+            lb = max(lb, g.anchored_degeneracy(anchors, solution));
+            if (is_target_reached())
+                return;
+            // CF-CTCP lists the triangles along the vertex ids, which should follow the degeneracy order
+            g.degeneracy_and_reduce(lb, nullptr, GraphWorkspace::local(), false);
+        }
+        if (g.n > lb && !past_deadline())
+        {
+            Reduction reduce(&g);
+            reduce.strong_reduce(lb);
+        }
+        ui anchor_cnt = 0; // a reduced anchor is in no k-plex larger than lb
+        for (ui u = 0; u < g.n; u++)
+            anchor_cnt += anchors.count(g.map_refresh_id[u]);
+        printf("After reduce, n= %u , m= %u , lb= %d\n", g.n, g.m / 2, lb);
+        t.print_time();
+        stats.heuris_lb = lb;
+        stats.solved_by_heuris = g.n <= lb || anchor_cnt < anchors.size();
+        if (stats.solved_by_heuris || past_deadline())
+            return;
+
+        puts("------------------{start BRB_Rec}---------------------");
+        Timer t_bnb;
+        bnb();
+        stats.bnb_time = t_bnb.get_time();
+    }
+
+public:
+    set<ui> solution; // the vertices of the maximum k-plex, in the ids of the input graph
+    SolverStats stats;
+
+    /**
+     * @param _core if not NULL, the core numbers of _input (see Graph::get_core_numbers), so that solve() only copies
+     * the part of _input that can hold a k-plex larger than the seed
+     */
+    Solver(const Graph &_input, int _k, const vector<ui> *_core = nullptr)
+        : input(_input), core(_core), k(_k), time_budget(0), target(0), algorithm_start_time(0)
+    {
+#ifdef PIPELINE_IE
+        pipelined = true;
+#endif
+    }
+
+    /**
+     * @brief start from a known k-plex s of the input graph, i.e., lb=|s|; any (k-1)-plex is also a k-plex
+     */
+    void set_seed(const set<ui> &s)
+    {
+        seed = s;
+    }
+
+    /**
+     * @brief search the maximum k-plex that contains all the vertices of s, instead of the maximum one of the graph;
+     * only the k-plexes with at least 2k-1 vertices are searched, so the solution is s itself if there is none,
+     * and it is empty if s is not a k-plex
+     */
+    void set_anchors(const set<ui> &s)
+    {
+        anchors = s;
+    }
+
+    /**
+     * @brief solve() stops after about seconds since it starts, and reports the best solution found so far
+     * StrongHeuris uses at most half of the time left; a single preprocessing pass (e.g., CF-CTCP) is not
+     * interrupted, but the rest of the passes are skipped once the time is up
+     */
+    void set_time_limit(double seconds)
+    {
+        time_budget = seconds * 1e6;
+    }
+    /**
+     * @brief decision mode: solve() only tells whether there is a k-plex of at least s vertices, so it starts from
+     * lb=s-1 (which makes every reduction stronger) and stops at the first such k-plex; s=0 turns it off
+     */
+    void set_target(int s)
+    {
+        target = s;
+    }
+#ifdef PIPELINE_IE
+    /**
+     * @brief false: BRB_Rec runs on the calling thread only, e.g., when the other cores are busy with other queries
+     */
+    void set_pipelined(bool _pipelined)
+    {
+        pipelined = _pipelined;
+    }
+#endif
+
+    /**
+     * @brief whether solution is proved to be a maximum k-plex by the last solve(), among the ones containing the
+     * anchors if set_anchors() is used
+     */
+    bool is_maximum() const
+    {
+        return target == 0 && !stats.timed_out && solution.size() >= 2 * k - 1; // otherwise, solution is only heuristic
+    }
+
+    /**
+     * @brief decision mode: whether the last solve() answered the query, and if so, the answer is is_target_reached()
+     * a k-plex with less than 2k-1 vertices is only found by heuristic, so a smaller target may be left unanswered
+     */
+    bool is_decided() const
+    {
+        return is_target_reached() || (!stats.timed_out && target >= 2 * k - 1);
+    }
+
+    /**
+     * @brief decision mode: whether solution has at least target vertices
+     */
+    bool is_target_reached() const
+    {
+        return target > 0 && solution.size() >= target;
+    }
+
+    /**
+     * @brief compute a maximum k-plex of the input graph
+     * @return the size of solution
+     */
+    int solve()
+    {
+        algorithm_start_time = get_system_time_microsecond();
+        paramK = k;
+        list_triangle_time = 0;
+        solution = seed;
+        lb = solution.size();
+        if (target > 0)
+            lb = max(lb, target - 1); // only the k-plexes larger than target-1 answer the query
+        stats = SolverStats();
+        if (anchors.size())
+        {
+            anchored_search();
+            g = Graph();
+            stats.list_triangle_time = list_triangle_time;
+            stats.total_time = get_system_time_microsecond() - algorithm_start_time;
+            return solution.size();
+        }
+        int min_core = max(lb, 2 * paramK - 2) + 1 - paramK; // the vertices with core+k<=lb are in no larger plex
+        if (core != nullptr && min_core > 0)
+            g = input.induce_by_core(*core, min_core);
+        else
+            g = input;
+        GraphWorkspace::local().reserve(g.n, g.m); // the graph rebuilds in preprocessing reuse these buffers
+
+        // KPHeuris
+        puts("------------------{start KPHeuris}---------------------");
+        Timer prepro("heuristic and preprocess");
+        if (!heuris())
+            prepro.print_time();
+        stats.solved_by_heuris = !stats.timed_out && g.n <= lb;
+        print_heuris_log();
+        stats.heuris_lb = lb;
+        GraphWorkspace::local().release(); // the buffers sized to the input graph are much larger than any g_i
+
+        if (!stats.solved_by_heuris && !past_deadline())
+        {
+            // recursive branch and bound
+            puts("------------------{start BRB_Rec}---------------------");
+            Timer t_bnb;
+            bnb();
+            stats.bnb_time = t_bnb.get_time();
+        }
+        g = Graph();
+
+        stats.list_triangle_time = list_triangle_time;
+        stats.total_time = get_system_time_microsecond() - algorithm_start_time;
+        return solution.size();
+    }
+};
+
+#endif
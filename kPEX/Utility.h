@@ -15,10 +15,121 @@ using pii = pair<ui, ui>;
 
 const int INF = 0x3f3f3f3f;
 
-int paramK;
-int lb;
+// the context of the query solved by this thread (see Solver.h), so that several queries can run concurrently
+thread_local int paramK;
+thread_local int lb;
 
-double list_triangle_time;
+/**
+ * @brief k as seen by the code specialized on k: ParamK<K>::paramK is the constant K,
+ * and ParamK<0>::paramK is the run-time paramK of the constructing thread (the generic version)
+ * get() is the same value for the code that has no ParamK object
+ */
+template <int K>
+struct ParamK
+{
+    static constexpr int paramK = K;
+    static int get() { return K; }
+};
+template <int K>
+constexpr int ParamK<K>::paramK;
+template <>
+struct ParamK<0>
+{
+    int paramK;
+    ParamK() : paramK(::paramK) {}
+    static int get() { return ::paramK; }
+};
+
+/**
+ * @brief a boolean array whose clear() is O(1): x is marked <==> stamp[x]==epoch
+ * the stamps are only reset when the epoch overflows
+ */
+class EpochMarker
+{
+    vector<uint32_t> stamp;
+    uint32_t epoch;
+
+public:
+    EpochMarker() : epoch(1) {}
+    EpochMarker(size_t n) : stamp(n, 0), epoch(1) {}
+
+    /**
+     * @brief the new positions are not marked, and the old ones are kept
+     */
+    void resize(size_t n)
+    {
+        stamp.resize(n, 0);
+    }
+    size_t size() const
+    {
+        return stamp.size();
+    }
+    inline bool operator[](size_t x) const
+    {
+        return stamp[x] == epoch;
+    }
+    inline void set(size_t x)
+    {
+        stamp[x] = epoch;
+    }
+    inline void reset(size_t x)
+    {
+        stamp[x] = 0;
+    }
+    void clear()
+    {
+        if (++epoch == 0)
+        {
+            fill(stamp.begin(), stamp.end(), 0);
+            epoch = 1;
+        }
+    }
+};
+
+/**
+ * @brief an array whose clear() resets all values to init_val in O(1); the value of x is valid <==> stamp[x]==epoch
+ */
+template <typename T>
+class EpochArray
+{
+    vector<T> val;
+    vector<uint32_t> stamp;
+    uint32_t epoch;
+    T init_val;
+
+public:
+    EpochArray(T _init_val = T()) : epoch(1), init_val(_init_val) {}
+    EpochArray(size_t n, T _init_val = T()) : val(n, _init_val), stamp(n, 0), epoch(1), init_val(_init_val) {}
+
+    void resize(size_t n)
+    {
+        val.resize(n, init_val);
+        stamp.resize(n, 0);
+    }
+    size_t size() const
+    {
+        return stamp.size();
+    }
+    inline T &operator[](size_t x)
+    {
+        if (stamp[x] != epoch)
+        {
+            stamp[x] = epoch;
+            val[x] = init_val;
+        }
+        return val[x];
+    }
+    void clear()
+    {
+        if (++epoch == 0)
+        {
+            fill(stamp.begin(), stamp.end(), 0);
+            epoch = 1;
+        }
+    }
+};
+
+thread_local double list_triangle_time;
 
 inline ll get_system_time_microsecond()
 {
@@ -0,0 +1,194 @@
+#include "Solver.h"
+
+#include <sys/stat.h>
+
+/**
+ * kpex_batch: solve the instances of a manifest on a shared pool of threads and write one results file
+ * each line of the manifest is an instance "graph_path k [time_limit_seconds]"; empty lines and lines starting
+ * with '#' are skipped
+ * a fixed set of worker threads takes the instances from the largest graph file (so that a large one does not
+ * start last), and the small ones fill the rest of the threads; a worker keeps its thread-local buffers across
+ * its instances; with -DPIPELINE_IE, an instance whose graph file has at least BATCH_LARGE_BYTES bytes takes
+ * 2 threads and builds its subgraphs in the second one
+ * a graph is loaded once for all of its instances, and is released after the last one finishes
+ */
+
+#ifndef BATCH_LARGE_BYTES
+#define BATCH_LARGE_BYTES (64 << 20)
+#endif
+
+struct Instance
+{
+    string path;
+    int k;
+    double time_limit; // seconds, 0 means no limit
+    ll file_size;
+    string result; // the line written to the results file
+};
+
+/**
+ * @brief a graph shared by the instances on it
+ */
+struct SharedGraph
+{
+    mutex mtx; // the first instance loads the graph while the others wait
+    unique_ptr<Graph> g;
+    vector<ui> core;
+    int remaining = 0; // the instances that have not finished
+};
+
+map<string, SharedGraph> graphs;
+mutex graphs_mtx;
+
+vector<Instance> instances;
+vector<int> order; // the instances from the largest graph file
+int next_pos = 0;  // order[next_pos] is the next instance to start
+int free_threads;  // a worker running an instance takes 1 thread, or 2 with the pipelined subgraph building
+mutex pool_mtx;
+condition_variable pool_cv;
+
+void run_instance(Instance &inst)
+{
+    SharedGraph *G;
+    {
+        lock_guard<mutex> lock(graphs_mtx);
+        G = &graphs[inst.path];
+    }
+    ostringstream out;
+    out << inst.path << ' ' << inst.k << ' ';
+    try
+    {
+        {
+            lock_guard<mutex> lock(G->mtx);
+            if (G->g == nullptr)
+            {
+                paramK = inst.k; // only logged by readFromFile
+                unique_ptr<Graph> g(new Graph());
+                g->readFromFile(inst.path);
+                G->core = g->get_core_numbers();
+                G->g = move(g);
+            }
+        }
+        Solver solver(*G->g, inst.k, &G->core);
+        if (inst.time_limit > 0)
+            solver.set_time_limit(inst.time_limit);
+#ifdef PIPELINE_IE
+        solver.set_pipelined(inst.file_size >= BATCH_LARGE_BYTES);
+#endif
+        solver.solve();
+        out << solver.solution.size() << ' ' << solver.is_maximum() << ' ' << fixed << setprecision(4)
+            << solver.stats.total_time / 1e6;
+    }
+    catch (const exception &e)
+    {
+        out << "error " << e.what();
+    }
+    inst.result = out.str();
+    {
+        lock_guard<mutex> lock(G->mtx);
+        if (--G->remaining == 0)
+        {
+            G->g.reset();
+            vector<ui>().swap(G->core);
+        }
+    }
+    fprintf(stderr, "done: %s\n", inst.result.c_str());
+}
+
+/**
+ * @return the threads that an instance takes
+ */
+int threads_needed(const Instance &inst, int threads)
+{
+#ifdef PIPELINE_IE
+    if (inst.file_size >= BATCH_LARGE_BYTES)
+        return min(2, threads);
+#endif
+    return 1;
+}
+
+/**
+ * @brief a worker runs the instances in order until there is none left
+ */
+void worker(int threads)
+{
+    unique_lock<mutex> lock(pool_mtx);
+    while (true)
+    {
+        pool_cv.wait(lock, [&]()
+                     { return next_pos == order.size() || free_threads >= threads_needed(instances[order[next_pos]], threads); });
+        if (next_pos == order.size())
+            return;
+        Instance &inst = instances[order[next_pos++]];
+        int need = threads_needed(inst, threads);
+        free_threads -= need;
+        lock.unlock();
+        run_instance(inst);
+        lock.lock();
+        free_threads += need;
+        pool_cv.notify_all();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        printf("2 params are required !!! \n");
+        printf("usage: ./kpex_batch manifest_path result_path [threads] [time_limit_seconds]\n");
+        exit(1);
+    }
+    int threads = argc > 3 ? atoi(argv[3]) : (int)thread::hardware_concurrency();
+    threads = max(threads, 1);
+    double default_time_limit = argc > 4 ? atof(argv[4]) : 0;
+
+    {
+        ifstream in(argv[1]);
+        if (!in.is_open())
+        {
+            printf("Failed to open %s \n", argv[1]);
+            exit(1);
+        }
+        string line;
+        while (getline(in, line))
+        {
+            istringstream ls(line);
+            Instance inst;
+            if (line.empty() || line[0] == '#' || !(ls >> inst.path >> inst.k))
+                continue;
+            if (!(ls >> inst.time_limit))
+                inst.time_limit = default_time_limit;
+            struct stat st;
+            inst.file_size = stat(inst.path.c_str(), &st) == 0 ? st.st_size : 0;
+            instances.push_back(inst);
+            graphs[inst.path].remaining++;
+        }
+    }
+    ofstream result(argv[2]);
+    if (!result.is_open())
+    {
+        printf("Failed to open %s \n", argv[2]);
+        exit(1);
+    }
+
+    // the largest instances first
+    order.resize(instances.size());
+    for (int i = 0; i < order.size(); i++)
+        order[i] = i;
+    stable_sort(order.begin(), order.end(), [&](int a, int b)
+                { return instances[a].file_size > instances[b].file_size; });
+
+    Timer t;
+    free_threads = threads;
+    vector<thread> workers;
+    for (int i = 0; i < min(threads, (int)instances.size()); i++)
+        workers.emplace_back(worker, threads);
+    for (auto &w : workers)
+        w.join();
+
+    result << "# graph_path k size exact time(s)\n";
+    for (auto &inst : instances)
+        result << inst.result << '\n';
+    fprintf(stderr, "%d instances on %d threads, batch time: %.4lf s\n", (int)instances.size(), threads, t.get_time() / 1e6);
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include <bits/stdc++.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+/**
+ * kpex_client: send requests to kpexd and print the responses, see kpexd.cpp for the protocol
+ * the request is given by the rest params, e.g., ./kpex_client /tmp/kpexd.sock solve ../data/bin/brock200-2.bin 2
+ * otherwise, each line of stdin is a request
+ */
+
+/**
+ * @brief send a request and read the response line
+ */
+bool query(int fd, const string &request, string &response)
+{
+    string line = request + "\n";
+    if (write(fd, line.data(), line.size()) < 0)
+        return false;
+    response.clear();
+    char ch;
+    while (read(fd, &ch, 1) == 1)
+    {
+        if (ch == '\n')
+            return true;
+        response.push_back(ch);
+    }
+    return false;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printf("1 param is required !!! \n");
+        printf("usage: ./kpex_client socket_path [request]\n");
+        exit(1);
+    }
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, argv[1], sizeof(addr.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        printf("Failed to connect to %s\n", argv[1]);
+        exit(1);
+    }
+
+    vector<string> requests;
+    if (argc > 2)
+    {
+        string request = argv[2];
+        for (int i = 3; i < argc; i++)
+            request += string(" ") + argv[i];
+        requests.push_back(request);
+    }
+    else
+    {
+        string line;
+        while (getline(cin, line))
+            if (line.size())
+                requests.push_back(line);
+    }
+    int ret = 0;
+    for (string &request : requests)
+    {
+        string response;
+        if (!query(fd, request, response))
+        {
+            printf("Connection closed by kpexd\n");
+            ret = 1;
+            break;
+        }
+        puts(response.c_str());
+        fflush(stdout);
+        if (response.compare(0, 5, "error") == 0)
+            ret = 1;
+    }
+    close(fd);
+    return ret;
+}
@@ -0,0 +1,321 @@
+#include "Solver.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/**
+ * kpexd: a resident solver that keeps the loaded graphs in memory and answers queries over a Unix domain socket
+ * each request is one line, and so is each response ("ok ..." or "error ..."):
+ *   load <graph_path>                                  -> ok n= <n> m= <m> load-time= <s>
+ *   solve <graph_path> <k> [seed=v1,v2,...] [time=<s>] -> ok size= <s> exact= <0|1> time= <s> solution= v1,v2,...
+ *   solve ... target=<s>                                -> ok size= <s> exact= 0 answer= <yes|no|unknown> time= ...
+ *   solve ... anchors=v1,v2,...                         -> the maximum k-plex that contains the anchors
+ *   drop <graph_path>                                  -> ok
+ *   list                                               -> ok <graph_path> n= <n> m= <m> ; ...
+ *   shutdown                                           -> ok; kpexd exits once the running queries have replied
+ * a graph is loaded by its first query, so only that query pays the ingest
+ */
+
+/**
+ * @brief a loaded graph and its preprocessing that does not depend on k
+ */
+struct LoadedGraph
+{
+    mutex mtx; // the first query loads the graph while the later ones on it wait
+    atomic<bool> loaded{false};
+    Graph g;
+    vector<ui> core; // the core numbers of g, see Solver(input, k, core)
+};
+
+map<string, shared_ptr<LoadedGraph>> graphs;
+mutex graphs_mtx;
+atomic<bool> stopping(false);
+int listen_fd = -1;
+
+/**
+ * @brief a connected client and the thread that serves it
+ */
+struct Session
+{
+    int fd; // -1 once the client is closed
+    thread worker;
+};
+map<int, Session> sessions; // by session id
+vector<int> finished;       // the sessions whose thread is about to return, joined by main
+mutex sessions_mtx;
+
+/**
+ * @brief the loaded graph of path; it is loaded now if it is not in memory
+ * only the entry is created under graphs_mtx, so a cold load does not block the queries on other graphs
+ */
+shared_ptr<LoadedGraph> get_graph(const string &path)
+{
+    shared_ptr<LoadedGraph> G;
+    {
+        lock_guard<mutex> lock(graphs_mtx);
+        shared_ptr<LoadedGraph> &h = graphs[path];
+        if (h == nullptr)
+            h = make_shared<LoadedGraph>();
+        G = h;
+    }
+    if (G->loaded)
+        return G;
+    lock_guard<mutex> lock(G->mtx);
+    if (!G->loaded)
+    {
+        try
+        {
+            G->g.readFromFile(path);
+            G->core = G->g.get_core_numbers();
+        }
+        catch (...)
+        {
+            lock_guard<mutex> lock(graphs_mtx);
+            auto it = graphs.find(path);
+            if (it != graphs.end() && it->second == G)
+                graphs.erase(it);
+            throw;
+        }
+        G->loaded = true;
+    }
+    return G;
+}
+
+/**
+ * @brief parse v1,v2,... into s
+ */
+void parse_vertices(const string &list, set<ui> &s)
+{
+    istringstream vs(list);
+    string v;
+    while (getline(vs, v, ','))
+        if (v.size())
+            s.insert(stoul(v));
+}
+
+string handle_solve(istringstream &in)
+{
+    string path;
+    int k = 0;
+    if (!(in >> path >> k) || k < 1)
+        return "error usage: solve <graph_path> <k> [seed=v1,v2,...] [time=<seconds>] [target=<size>] [anchors=v1,v2,...]";
+    set<ui> seed, anchors;
+    double time_limit = 0;
+    int target = 0;
+    string opt;
+    while (in >> opt)
+    {
+        if (opt.compare(0, 5, "seed=") == 0)
+            parse_vertices(opt.substr(5), seed);
+        else if (opt.compare(0, 8, "anchors=") == 0)
+            parse_vertices(opt.substr(8), anchors);
+        else if (opt.compare(0, 5, "time=") == 0)
+            time_limit = stod(opt.substr(5));
+        else if (opt.compare(0, 7, "target=") == 0)
+            target = stoi(opt.substr(7));
+        else
+            return "error unknown option " + opt;
+    }
+    shared_ptr<LoadedGraph> G = get_graph(path);
+    if (!G->g.is_plex(seed, k))
+        return "error the seed is not a k-plex of " + path;
+    if (!G->g.is_plex(anchors, k))
+        return "error the anchors are not a k-plex of " + path;
+
+    Solver solver(G->g, k, &G->core);
+    solver.set_seed(seed);
+    if (time_limit > 0)
+        solver.set_time_limit(time_limit);
+    solver.set_target(target);
+    solver.set_anchors(anchors);
+    solver.solve();
+
+    ostringstream out;
+    out << "ok size= " << solver.solution.size() << " exact= " << solver.is_maximum();
+    if (target > 0)
+        out << " answer= " << (solver.is_target_reached() ? "yes" : solver.is_decided() ? "no" : "unknown");
+    out << " time= " << fixed << setprecision(4) << solver.stats.total_time / 1e6 << " solution= ";
+    bool first = true;
+    for (ui v : solver.solution)
+    {
+        out << (first ? "" : ",") << v;
+        first = false;
+    }
+    return out.str();
+}
+
+/**
+ * @return the response line of a request
+ */
+string handle(const string &line)
+{
+    istringstream in(line);
+    string cmd, path;
+    in >> cmd;
+    if (stopping)
+        return "error kpexd is shutting down";
+    try
+    {
+        if (cmd == "solve")
+            return handle_solve(in);
+        if (cmd == "load")
+        {
+            if (!(in >> path))
+                return "error usage: load <graph_path>";
+            Timer t;
+            shared_ptr<LoadedGraph> G = get_graph(path);
+            ostringstream out;
+            out << "ok n= " << G->g.n << " m= " << G->g.m / 2 << " load-time= " << fixed << setprecision(4)
+                << t.get_time() / 1e6;
+            return out.str();
+        }
+        if (cmd == "drop")
+        {
+            if (!(in >> path))
+                return "error usage: drop <graph_path>";
+            lock_guard<mutex> lock(graphs_mtx);
+            graphs.erase(path); // a running query keeps its graph alive until it finishes
+            return "ok";
+        }
+        if (cmd == "list")
+        {
+            lock_guard<mutex> lock(graphs_mtx);
+            ostringstream out;
+            out << "ok";
+            for (auto &h : graphs)
+                if (h.y->loaded) // the graphs being loaded are not listed yet
+                    out << ' ' << h.x << " n= " << h.y->g.n << " m= " << h.y->g.m / 2 << " ;";
+            return out.str();
+        }
+        if (cmd == "shutdown")
+        {
+            stopping = true; // serve() wakes up accept() after the response is sent
+            return "ok";
+        }
+    }
+    catch (const exception &e)
+    {
+        return string("error ") + e.what();
+    }
+    return "error unknown request: " + line;
+}
+
+/**
+ * @brief answer the requests of a client line by line until it disconnects
+ */
+void serve(int id, int fd)
+{
+    string buf;
+    char chunk[4096];
+    ssize_t len;
+    while (!stopping && (len = read(fd, chunk, sizeof(chunk))) > 0)
+    {
+        buf.append(chunk, len);
+        size_t pos;
+        while ((pos = buf.find('\n')) != string::npos)
+        {
+            string line = buf.substr(0, pos);
+            buf.erase(0, pos + 1);
+            if (line.size() && line.back() == '\r')
+                line.pop_back();
+            if (line.empty())
+                continue;
+            string response = handle(line) + "\n";
+            if (write(fd, response.data(), response.size()) < 0)
+                break;
+            if (stopping)
+            {
+                shutdown(listen_fd, SHUT_RDWR); // wake up accept() in main
+                break;
+            }
+        }
+    }
+    lock_guard<mutex> lock(sessions_mtx);
+    close(fd);
+    sessions[id].fd = -1;
+    finished.push_back(id);
+}
+
+/**
+ * @brief join the threads of the sessions in finished, or of all sessions
+ */
+void join_sessions(bool all)
+{
+    vector<thread> workers;
+    {
+        lock_guard<mutex> lock(sessions_mtx);
+        if (all)
+            for (auto &h : sessions)
+                finished.push_back(h.x);
+        for (int id : finished)
+        {
+            auto it = sessions.find(id);
+            if (it == sessions.end())
+                continue;
+            workers.push_back(move(it->second.worker));
+            sessions.erase(it);
+        }
+        finished.clear();
+    }
+    for (auto &w : workers)
+        w.join();
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printf("1 param is required !!! \n");
+        printf("usage: ./kpexd socket_path\n");
+        exit(1);
+    }
+    string socket_path = argv[1];
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path))
+    {
+        printf("socket path is too long: %s\n", socket_path.c_str());
+        exit(1);
+    }
+    strcpy(addr.sun_path, socket_path.c_str());
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socket_path.c_str());
+    if (listen_fd < 0 || ::bind(listen_fd, (sockaddr *)&addr, sizeof(addr)) < 0 || listen(listen_fd, 16) < 0)
+    {
+        printf("Failed to listen on %s\n", socket_path.c_str());
+        exit(1);
+    }
+    printf("kpexd listens on %s\n", socket_path.c_str());
+    fflush(stdout);
+
+    // each client is served by its own thread, so the queries of different clients run concurrently
+    int session_cnt = 0;
+    while (!stopping)
+    {
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        join_sessions(false);
+        lock_guard<mutex> lock(sessions_mtx);
+        int id = session_cnt++;
+        sessions[id].fd = fd;
+        sessions[id].worker = thread(serve, id, fd);
+    }
+    close(listen_fd);
+    unlink(socket_path.c_str());
+
+    // the running queries finish and reply, while the idle clients are woken up from read()
+    {
+        lock_guard<mutex> lock(sessions_mtx);
+        for (auto &h : sessions)
+            if (h.y.fd >= 0)
+                shutdown(h.y.fd, SHUT_RD);
+    }
+    join_sessions(true);
+    return 0;
+}
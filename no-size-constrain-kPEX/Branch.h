@@ -9,12 +9,46 @@
 #include "2th-Reduction.h"
 #endif
 
-class Branch
+// AltRB stops iterating once a round reduces less than 1/AltRB_min_gain_ratio of C
+#ifndef AltRB_min_gain_ratio
+#define AltRB_min_gain_ratio 64
+#endif
+
+// if the density of g_i is at least COMPLEMENT_MIN_DENSITY, reduce_kPlexT visits the non-neighbors (the complement) only
+#ifndef COMPLEMENT_MIN_DENSITY
+#define COMPLEMENT_MIN_DENSITY 0.8
+#endif
+
+// the producer of PIPELINE_IE already owns G_input and reacts to a larger lb, so BACKGROUND_CTCP is not needed
+#if defined(PIPELINE_IE) && defined(BACKGROUND_CTCP)
+#undef BACKGROUND_CTCP
+#endif
+
+/**
+ * @brief K>0: the branch-and-bound is compiled for k=K, so the thresholds are constants;
+ * K=0: k is read from the global paramK
+ */
+template <int K>
+class Branch : public ParamK<K>
 {
 private:
+    using ParamK<K>::paramK;
     using Set = MyBitset;
     Graph_reduced &G_input;
     int lb;
+    double deadline; // the search stops once get_system_time_microsecond() passes it; 0 means no time limit
+    bool timed_out;  // the search stopped at the deadline, so solution may be not maximum
+    int target;      // the search stops once lb reaches target, i.e., decision mode; 0 means no target
+    bool stopped;    // the rest of the search is skipped, since the deadline is passed or the target is reached
+#ifdef PIPELINE_IE
+    atomic<int> shared_lb; // lb published to the producer of pipelined_IE
+    bool pipelined;        // otherwise serial_IE is used, e.g., for the small instances of a batch
+#endif
+#ifdef BACKGROUND_CTCP
+    thread ctcp_worker;          // runs G_input.CTCP(ctcp_worker_lb) while bnb goes on, and owns G_input until joined
+    int ctcp_worker_lb;          // the lb that ctcp_worker reduces G_input with
+    double background_CTCP_time; // written by ctcp_worker
+#endif
 
     // info of the search tree
     int v_just_add;       // the pivot vertex that we just added into S
@@ -23,14 +57,25 @@ private:
     vector<int> one_loss_non_neighbor_cnt;
     vector<int> que; // queue
     Set one_loss_vertices_in_C;
-    AdjacentMatrix non_A, A; // A is the adjacent matrix, A[u] is the neighbors of u, A[u][v] means u,v are adj; non_A = ~A
+    AdjacentMatrix A; // A is the adjacent matrix, A[u] is the neighbors of u, A[u][v] means u,v are adj; the non-neighbors are counted by andnot_count
     Graph_adjacent *ptr_g;
 
     // arrays that can be shared
     vector<int> array_n; // n is the size of subgraph g_i, n >= |S| + |C|
     Set bool_array;
     vector<int> array_N; // N is the input graph size
-    vector<int> array1_N;
+    EpochArray<int> array1_N;
+    vector<ui> sub_pstart, sub_edge_to; // CSR of g_i before the reductions in CTCP_for_g_i
+    vector<int> bucket, order_C; // counting sort of C in reduce_kPlexT
+    bool use_complement;         // g_i is dense, so reduce_kPlexT works on non_adj
+    vector<vector<int>> non_adj; // non_adj[u] = the non-neighbors of u in g_i, i.e., the sparse complement graph
+    vector<int> pos_in_order;    // order_C[pos_in_order[u]] = u
+    vector<int> fenwick_cnt, fenwick_sum; // the count and the key sum of the positions of order_C that are still in C
+    vector<int> skipped_pos, skipped_key_sum;
+    Set AltRB_S, AltRB_C; // the copies of S and C used for partition in AltRB
+    Set useful_S;         // for v in useful_S, Pi_v is generated
+    Set candidate_S;      // for v in S-candidate_S, Pi_v is useless in the rest rounds of AltRB
+    int AltRB_ub;         // |S| + sum of (k-loss_cnt[v]) for v in useful_S, i.e., the ub of Pi_1, ..., Pi_|S| in the last round of AltRB
 
     // information of log
     ll dfs_cnt;
@@ -51,7 +96,12 @@ private:
 
 public:
     set<int> solution;
-    Branch(Graph_reduced &input, int _lb) : G_input(input), lb(_lb), bool_array(input.n),
+    Branch(Graph_reduced &input, int _lb, double _deadline = 0) : G_input(input), lb(_lb), deadline(_deadline),
+                                                                 timed_out(false), target(0), stopped(false),
+                                                                 bool_array(input.n),
+#ifdef PIPELINE_IE
+                                                                 pipelined(true),
+#endif
                                             dfs_cnt(0), run_time(0), fast_reduce_time(0), core_reduce_time(0),
                                             part_PI_time(0), IE_induce_time(0),
                                             matrix_init_time(0), IE_graph_cnt(0), IE_graph_size(0), CTCP_time(0),
@@ -62,6 +112,40 @@ public:
     {
     }
     ~Branch() {}
+    ll get_dfs_cnt() const
+    {
+        return dfs_cnt;
+    }
+    bool is_timed_out() const
+    {
+        return timed_out;
+    }
+    bool is_target_reached() const
+    {
+        return target > 0 && lb >= target;
+    }
+#ifdef PIPELINE_IE
+    void set_pipelined(bool _pipelined)
+    {
+        pipelined = _pipelined;
+    }
+#endif
+    /**
+     * @brief decision mode: stop at the first k-plex of at least _target vertices, i.e., lb>=_target
+     */
+    void set_target(int _target)
+    {
+        target = _target;
+    }
+    /**
+     * @brief whether the deadline is passed or the target is reached; once it is, the rest of the search is skipped
+     */
+    bool should_stop()
+    {
+        if (!stopped && deadline > 0 && get_system_time_microsecond() > deadline)
+            stopped = timed_out = true;
+        return stopped;
+    }
     /**
      * @brief Branch-aNd-Bound on subgraph g_i
      * i.e., BRB_Rec in paper
@@ -69,6 +153,8 @@ public:
     void bnb(Set &S, Set &C)
     {
         dfs_cnt++;
+        if (stopped || ((dfs_cnt & 1023) == 0 && should_stop()))
+            return;
 
         // reduction rules
         Timer start_fast_reduce;
@@ -125,61 +211,105 @@ public:
         G_input.init_before_IE();
         CTCP_time += get_system_time_microsecond() - start_IE;
         array_N.resize(G_input.n);
-        array1_N.resize(G_input.n, 0);
-        while (G_input.size() > lb)
+        array1_N.resize(G_input.n);
+#ifdef PIPELINE_IE
+        if (pipelined)
+            pipelined_IE();
+        else
+#endif
+            serial_IE();
+        run_time = get_system_time_microsecond() - start_IE;
+        print_progress_bar(1.0, true);
+
+        print_result();
+    }
+
+    /**
+     * @brief IE on one thread: build g_i, search it, and then remove v_i from G_input
+     */
+    void serial_IE()
+    {
+        while (G_input.size() > lb && !should_stop())
         {
             double percentage = 1.0 - G_input.size() * 1.0 / G_input.n;
             print_progress_bar(percentage);
-            double start_induce = get_system_time_microsecond();
-
-            int u = G_input.get_min_degree_v();
-            int previous_lb = lb;
 
-            auto &vis = bool_array;
-            vis.set(u);
-
-            vector<int> vertices_2hops{u};
-            G_input.induce_to_2hop_and_reduce(u, vis, vertices_2hops, array1_N, lb);
-            vector<pii> edges;
-            int id_u = CTCP_for_g_i(u, vis, vertices_2hops, array_N, edges, lb);
-            if (id_u != -1) // this subgraph is not pruned: begin bnb
-            {
-                subgraph_search_cnt++;
-                vector<int> &inv = array_N;
-                // Graph_adjacent g(vis, vertices_2hops, G_input, inv);
-                Graph_adjacent g(vertices_2hops, edges);
-                IE_induce_time += get_system_time_microsecond() - start_induce;
-                IE_graph_size += g.size();
-                IE_graph_cnt++;
-                matrix_init_time += g.init_time;
-                ptr_g = &g;
+            IE_step(G_input.get_min_degree_v());
+        }
+#ifdef BACKGROUND_CTCP
+        join_background_CTCP(lb);
+#endif
+    }
 
-                // int id_u = inv[u]; // the index of u in the new-induced graph g
-                {
-                    // higher order reduction
-                    Timer tt;
-                    g.edge_reduction(id_u, lb);
-                    higher_order_reduce_time += tt.get_time();
-                }
+    /**
+     * @brief one step of serial_IE: search the larger plexes in g_i that contain u, and then remove u from G_input
+     * @param anchors the vertices of G_input that the plexes must contain as well, see anchored_search()
+     */
+    void IE_step(int u, const vector<int> &anchors = vector<int>())
+    {
+        int previous_lb = lb;
 
-                Set S(g.size()), C(g.size());
-                S.set(id_u);
-                C.flip();
-                C.reset(id_u);
-                init_info(id_u, g);
-                v_just_add = id_u;
-                bnb(S, C); // BRB_Rec in paper
-            }
+        Graph_adjacent g;
+        int id_u = build_g_i(u, g, lb);
+        vector<int> id_anchors; // an anchor reduced from g_i is in no larger plex with u
+        for (int i = 0; id_u != -1 && i < anchors.size(); i++)
+        {
+            auto it = lower_bound(g.vertex_id.begin(), g.vertex_id.end(), anchors[i]);
+            if (it == g.vertex_id.end() || *it != anchors[i])
+                id_u = -1;
             else
-            {
-                IE_induce_time += get_system_time_microsecond() - start_induce;
-                subgraph_pruned_cnt++;
-            }
+                id_anchors.push_back(it - g.vertex_id.begin());
+        }
+        if (id_u != -1) // this subgraph is not pruned: begin bnb
+            search_g_i(g, id_u, id_anchors);
 
-            double start_CTCP = get_system_time_microsecond();
+        double start_CTCP = get_system_time_microsecond();
+#ifdef BACKGROUND_CTCP
+        previous_lb = join_background_CTCP(previous_lb); // now G_input is reduced with previous_lb
+#endif
+        if (id_u == -1) // a run of pruned g_i is removed with one CTCP cascade
+            G_input.remove_v_lazily(u, lb);
+        else
             G_input.remove_v(u, lb, lb > previous_lb ? true : false);
-            CTCP_time += get_system_time_microsecond() - start_CTCP;
+        CTCP_time += get_system_time_microsecond() - start_CTCP;
+    }
+
+    /**
+     * @brief instead of the maximum plex, search the larger plexes of G_input that contain all the anchors: IE only
+     * enumerates the other vertices as v_i, and S of each g_i starts from v_i and the anchors
+     * G_input should be the common 2-hop neighborhood of the anchors (see Graph::induce_common_2hop), so that each
+     * g_i keeps the anchors unless no larger plex contains them
+     */
+    void anchored_search(const vector<int> &anchors)
+    {
+        double start_IE = get_system_time_microsecond();
+        G_input.init_before_IE();
+        CTCP_time += get_system_time_microsecond() - start_IE;
+        array_N.resize(G_input.n);
+        array1_N.resize(G_input.n);
+        Set is_anchor(G_input.n);
+        for (int a : anchors)
+            is_anchor.set(a);
+        vector<int> order; // v_1, v_2, ...: the other vertices in ascending order of degree
+        for (int u : G_input.vertex)
+            if (!is_anchor[u])
+                order.push_back(u);
+        sort(order.begin(), order.end(), [&](int a, int b)
+             { return G_input.d[a] < G_input.d[b]; });
+        for (int u : order)
+        {
+            bool anchors_left = true; // CTCP removes an anchor only if no plex larger than lb contains it
+            for (int a : anchors)
+                if (!G_input.vertex[a])
+                    anchors_left = false;
+            if (!anchors_left || G_input.size() <= lb || should_stop())
+                break;
+            if (G_input.vertex[u])
+                IE_step(u, anchors);
         }
+#ifdef BACKGROUND_CTCP
+        join_background_CTCP(lb);
+#endif
         run_time = get_system_time_microsecond() - start_IE;
         print_progress_bar(1.0, true);
 
@@ -189,30 +319,62 @@ public:
     /**
      * @brief AltRB in paper, including ComputeUB and Partition
      * we partition C to |S| sets: Pi_0, Pi_1, ..., Pi_|S|; Pi_0 is C_R and the rest are C_L
-     * we will also reduce unpromissing vertices from C
+     * we will also reduce unpromissing vertices from C, and repeat until few vertices can be reduced
      * @return ub
      */
     int bound_and_reduce(Set &S, Set &C)
+    {
+        candidate_S = S;
+        while (1)
+        {
+            int initial_S_size = S.size(), initial_C_size = C.size();
+            int ret = bound_and_reduce_once(S, C);
+            if (ret <= lb)
+                return ret;
+            int C_size = C.size();
+            if (C_size == initial_C_size) // fixed point
+                return ret;
+            if (S.size() != initial_S_size) // RR2 moved Pi_0 into S, so loss_cnt[] is re-computed
+            {
+                candidate_S = S;
+                continue;
+            }
+            // C only shrank: stop if the last round reduced too few vertices
+            if ((initial_C_size - C_size) * AltRB_min_gain_ratio < initial_C_size)
+                return ret;
+        }
+    }
+
+    /**
+     * @brief one round of AltRB; the partition state (candidate_S) is kept across rounds where C only shrank
+     * @return ub
+     */
+    int bound_and_reduce_once(Set &S, Set &C)
     {
         AltRB_iteration_cnt++;
         Timer part_timer;
-        int initial_C_size = C.size();
-        auto copy_S = S;
-        auto copy_C = C;
+        auto &copy_S = AltRB_S;
+        auto &copy_C = AltRB_C;
+        copy_S = candidate_S;
+        copy_C = C;
         int S_sz = S.size();
         int ub = S_sz;
-        Set useful_S(S.range); // for v in useful_S, Pi_v is generated
+        useful_S.clear();
+        bool first_pick = true;
         // DisePUB: Partition
         while (copy_S.size())
         {
             int sel = -1, size = 0, allow = 0;
             for (int v : copy_S)
             {
-                int sz = non_A[v].intersect(copy_C);
+                int sz = copy_C.andnot_count(A[v]);
                 int allow_v = (paramK - loss_cnt[v]);
                 if (sz <= allow_v) // Pi_i is useless
                 {
                     copy_S.reset(v);
+                    // copy_C==C now; since C only shrinks, Pi_v remains useless in the later rounds
+                    if (first_pick)
+                        candidate_S.reset(v);
                 }
                 else
                 {
@@ -228,11 +390,13 @@ public:
                 break;
             if (lb + 1 > ub && size * 1.0 / allow <= copy_C.size() * 1.0 / (lb + 1 - ub))
                 break;
+            first_pick = false;
             copy_S.reset(sel);
             useful_S.set(sel);
             ub += allow;
             copy_C &= A[sel]; // remove the non-neighbors of sel
         }
+        AltRB_ub = ub;
         part_PI_time += part_timer.get_time();
 
 
@@ -272,7 +436,7 @@ public:
         //     int sel = -1, size = 0, allow = 0;
         //     for (int v : copy_S)
         //     {
-        //         int sz = non_A[v].intersect(copy_C);
+        //         int sz = copy_C.andnot_count(A[v]);
         //         int allow_v = (paramK - loss_cnt[v]);
         //         if (sz <= allow_v) // Pi_i is useless
         //         {
@@ -323,7 +487,7 @@ public:
                     }
                     else
                     {
-                        ub_u -= useful_S.intersect(non_A[u]);
+                        ub_u -= useful_S.andnot_count(A[u]);
                         if (ub_u <= lb)
                         {
                             C.reset(u);
@@ -342,7 +506,7 @@ public:
                     }
                     else
                     {
-                        ub_u = ub_u + 1 - useful_S.intersect(non_A[u]);
+                        ub_u = ub_u + 1 - useful_S.andnot_count(A[u]);
                         if (ub_u <= lb)
                             C.reset(u);
                     }
@@ -369,8 +533,6 @@ public:
             }
         }
 #endif
-        if (C.size() < initial_C_size) // goto next iteration
-            return bound_and_reduce(S, C);
         return ret;
     }
 
@@ -384,7 +546,7 @@ public:
         int ub = bound_and_reduce(S, C); // AltRB
         if (ub <= lb)
             return ub;
-        ub = only_part_UB(S, C); // just bounding without AltRB
+        ub = only_part_UB(S, C); // just bounding without AltRB, continuing the partition of AltRB
         return ub;
     }
 
@@ -426,6 +588,10 @@ public:
         puts("");
         puts("*************bnb result*************");
         printf("ground truth= %d , exact searching use time= %.4lf s\n", lb, run_time / 1e6);
+        if (timed_out)
+            printf("Time limit reached, the solution may be not maximum!\n");
+        if (is_target_reached())
+            printf("Target size %d reached, the search stops!\n", target);
         if (solution.size())
         {
             G_input.get_ground_truth(solution, true);
@@ -446,86 +612,270 @@ public:
         loss_cnt.resize(g.size());
         deg.clear();
         deg.resize(g.size());
-        non_A = g.adj_matrix;
-        non_A.flip();
         A = g.adj_matrix;
         array_n.clear();
         array_n.resize(g.size());
         one_loss_vertices_in_C = Set(g.size());
+        AltRB_S = AltRB_C = useful_S = candidate_S = Set(g.size());
         one_loss_non_neighbor_cnt.resize(g.size());
         que.resize(g.size());
+        use_complement = paramK > 10 && g.density() >= COMPLEMENT_MIN_DENSITY;
+        if (use_complement)
+        {
+            non_adj.resize(g.size());
+            Set non_neighbor(g.size());
+            for (int v = 0; v < g.size(); v++)
+            {
+                non_adj[v].clear();
+                non_neighbor = A[v];
+                non_neighbor.flip();
+                for (int w : non_neighbor)
+                    if (w != v)
+                        non_adj[v].push_back(w);
+            }
+            pos_in_order.resize(g.size());
+        }
+    }
+    /**
+     * @brief the first half of an IE step: induce the 2-hop subgraph g_i of u from G_input and reduce it with lb
+     * @return the index of u in g; -1 if g_i is pruned
+     */
+    int build_g_i(int u, Graph_adjacent &g, int lb)
+    {
+        double start_induce = get_system_time_microsecond();
+        auto &vis = bool_array;
+        vis.set(u);
+
+        vector<int> vertices_2hops{u};
+        G_input.induce_to_2hop_and_reduce(u, vis, vertices_2hops, array1_N, lb);
+        int id_u = CTCP_for_g_i(u, vis, vertices_2hops, array_N, g, lb);
+        IE_induce_time += get_system_time_microsecond() - start_induce;
+        if (id_u == -1)
+            subgraph_pruned_cnt++;
+        return id_u;
+    }
+    /**
+     * @brief the second half of an IE step: search the larger plexes in g that contain id_u
+     * @param anchors the other vertices of g that the plexes must contain, see anchored_search()
+     */
+    void search_g_i(Graph_adjacent &g, int id_u, const vector<int> &anchors = vector<int>())
+    {
+        subgraph_search_cnt++;
+        IE_graph_size += g.size();
+        IE_graph_cnt++;
+        matrix_init_time += g.init_time;
+        ptr_g = &g;
+
+        {
+            // higher order reduction
+            Timer tt;
+            g.edge_reduction<K>(id_u, lb);
+            higher_order_reduce_time += tt.get_time();
+        }
+
+        Set S(g.size()), C(g.size());
+        S.set(id_u);
+        C.flip();
+        C.reset(id_u);
+        for (int v : anchors)
+            S.set(v), C.reset(v);
+        init_info(id_u, g);
+        v_just_add = id_u;
+        bnb(S, C); // BRB_Rec in paper
+    }
+#ifdef BACKGROUND_CTCP
+    /**
+     * @brief lb rose inside bnb: reduce the rest of G_input with the new lb on a helper thread, so that a long
+     * search of g_i overlaps with the reduction; if a helper is already running, remove_v does the rest
+     */
+    void start_background_CTCP()
+    {
+        if (ctcp_worker.joinable())
+            return;
+        ctcp_worker_lb = lb;
+        ctcp_worker = thread([this](int lb, int k)
+                             {
+                                 ::paramK = k; // the helper solves the same query as this thread
+                                 Timer t;
+                                 G_input.CTCP(lb);
+                                 background_CTCP_time = t.get_time(); },
+                             lb, ::paramK);
+    }
+    /**
+     * @brief wait for the helper before G_input is used again
+     * @return the lb that G_input is reduced with, i.e., ctcp_worker_lb if a helper has run, otherwise previous_lb
+     */
+    int join_background_CTCP(int previous_lb)
+    {
+        if (!ctcp_worker.joinable())
+            return previous_lb;
+        ctcp_worker.join();
+        CTCP_time += background_CTCP_time;
+        return ctcp_worker_lb;
+    }
+#endif
+#ifdef PIPELINE_IE
+    /**
+     * @brief IE with two threads: a producer builds g_{i+1} and removes v_i from G_input while bnb searches g_i
+     * the producer only sees lb through shared_lb, so it may build g_j with a stale lb; such a g_j is still a
+     * superset of the exact one, and it is re-validated before searching
+     */
+    void pipelined_IE()
+    {
+        struct Slot
+        {
+            Graph_adjacent g;
+            int id_u, built_lb;
+            bool full;
+        } slots[2];
+        slots[0].full = slots[1].full = false;
+        bool producer_done = false;
+        mutex mtx;
+        condition_variable cv;
+        shared_lb.store(lb);
+        // the producer owns G_input and the arrays used by build_g_i; the consumer owns the rest
+        int k = ::paramK;
+        thread producer([&]()
+                        {
+            ::paramK = k; // the producer solves the same query as this thread
+            int cur = 0, previous_lb = shared_lb.load();
+            while (true)
+            {
+                int now_lb = shared_lb.load();
+                if (G_input.size() <= now_lb || (target > 0 && now_lb >= target) ||
+                    (deadline > 0 && get_system_time_microsecond() > deadline))
+                    break;
+                print_progress_bar(1.0 - G_input.size() * 1.0 / G_input.n);
+                int u = G_input.get_min_degree_v();
+                Slot &slot = slots[cur];
+                {
+                    unique_lock<mutex> lock(mtx);
+                    cv.wait(lock, [&]()
+                            { return !slot.full; });
+                }
+                int id_u = build_g_i(u, slot.g, now_lb);
+                if (id_u != -1)
+                {
+                    slot.id_u = id_u, slot.built_lb = now_lb;
+                    {
+                        lock_guard<mutex> lock(mtx);
+                        slot.full = true;
+                    }
+                    cv.notify_all();
+                    cur ^= 1;
+                }
+                double start_CTCP = get_system_time_microsecond();
+                now_lb = shared_lb.load();
+                if (id_u == -1 && now_lb == previous_lb)
+                    G_input.remove_v_lazily(u, now_lb);
+                else
+                    G_input.remove_v(u, now_lb, now_lb > previous_lb);
+                previous_lb = now_lb;
+                CTCP_time += get_system_time_microsecond() - start_CTCP;
+            }
+            {
+                lock_guard<mutex> lock(mtx);
+                producer_done = true;
+            }
+            cv.notify_all(); });
+        int cur = 0;
+        ll revalidate_pruned_cnt = 0;
+        while (true)
+        {
+            Slot &slot = slots[cur];
+            {
+                unique_lock<mutex> lock(mtx);
+                cv.wait(lock, [&]()
+                        { return slot.full || producer_done; });
+                if (!slot.full) // the slots are filled in turn, so none is left
+                    break;
+            }
+            // lb rose after g_i was built: g_i keeps the vertices of a (built_lb+1-k)-core, re-check its size
+            if (slot.built_lb < lb && slot.g.size() <= lb)
+                revalidate_pruned_cnt++;
+            else if (!should_stop()) // after the deadline or the target, the producer stops soon and the built g_i are dropped
+                search_g_i(slot.g, slot.id_u);
+            {
+                lock_guard<mutex> lock(mtx);
+                slot.full = false;
+            }
+            cv.notify_all();
+            cur ^= 1;
+        }
+        producer.join();
+        subgraph_pruned_cnt += revalidate_pruned_cnt;
     }
+#endif
     /**
-     * @return the index of v in the subgraph
+     * @brief build g_i=G[vertices] in CSR, reduce it, and write the rest into the matrix of g if it is not pruned
+     * @return the index of v in the subgraph; -1 if the subgraph is pruned
      */
-    int CTCP_for_g_i(int v, MyBitset &V_mask, vector<int> &vertices, vector<int> &inv, vector<pii> &edges, int lb)
+    int CTCP_for_g_i(int v, MyBitset &V_mask, vector<int> &vertices, vector<int> &inv, Graph_adjacent &g, int lb)
     {
         if (!V_mask[v]) // the subgraph is already pruned due to core-reduction for N(v) and N^2(v)
             return -1;
-        auto &g = G_input;
+        auto &G = G_input;
         sort(vertices.begin(), vertices.end());
-        for (int i = 0; i < (int)vertices.size(); i++)
+        int n = vertices.size();
+        for (int i = 0; i < n; i++)
             inv[vertices[i]] = i;
-        for (int u : vertices)
+        sub_pstart.resize(n + 1);
+        sub_edge_to.clear();
+        for (int i = 0; i < n; i++)
         {
-            for (int i = g.pstart[u]; i < g.pstart[u + 1]; i++)
+            int u = vertices[i];
+            sub_pstart[i] = sub_edge_to.size();
+            for (int j = G.pstart[u]; j < G.pstart[u + 1]; j++)
             {
-                if (g.edge_removed[i])
+                if (G.edge_removed[j])
                     continue;
-                int v = g.edge_to[i];
-                if (!V_mask[v])
+                int w = G.edge_to[j];
+                if (!V_mask[w])
                     continue;
-                edges.push_back({inv[u], inv[v]});
-            }
-        }
-        Graph g_i(vertices, edges);
-        if (paramK > 10)
-        {
-            g_i.weak_reduce(lb);
-            if (g_i.n > lb)
-            {
-                Reduction reduce(&g_i);
-                reduce.strong_reduce(lb);
+                sub_edge_to.push_back(inv[w]);
             }
         }
+        sub_pstart[n] = sub_edge_to.size();
         // clear the mask
         for (int u : vertices)
         {
             assert(V_mask[u]);
             V_mask.reset(u);
         }
+        if (paramK <= 10)
+        {
+            if (n <= lb)
+                return -1;
+            g.init_from_CSR(vertices, sub_pstart.data(), sub_edge_to.data());
+            return inv[v];
+        }
+        Graph g_i(vertices, sub_pstart, sub_edge_to);
+        g_i.weak_reduce(lb);
         if (g_i.n > lb)
         {
-            // current subgraph can not be pruned and we need to search it,
-            // so we prepare edges[] and vertices[] to build graph using adj-matrix
-            int ret = -1;
-            for (int i = 0; i < g_i.n; i++)
-                if (vertices[i] == v)
-                {
-                    ret = i;
-                    break;
-                }
-            if (ret != -1) // v is still in the subgraph
-            {
-                if (g_i.m != edges.size())
-                {
-                    edges.clear();
-                    vertices.resize(g_i.n);
-                    for (ui u = 0; u < g_i.n; u++)
-                    {
-                        vertices[u] = g_i.map_refresh_id[u];
-                        for (ui i = g_i.pstart[u]; i < g_i.pstart[u + 1]; i++)
-                        {
-                            ui v = g_i.edge_to[i];
-                            edges.push_back({u, v});
-                        }
-                    }
-                }
-                return ret;
-            }
+            Reduction reduce(&g_i);
+            reduce.strong_reduce(lb);
         }
-        // subgraph is pruned
-        return -1;
+        // the CSR arrays of g_i go back to the workspace so that the next g_i is built without allocation
+        if (g_i.n <= lb)
+        {
+            g_i.recycle();
+            return -1;
+        }
+        // the rest vertices keep their order, so v can be found by binary search
+        auto it = lower_bound(g_i.map_refresh_id.begin(), g_i.map_refresh_id.begin() + g_i.n, (ui)v);
+        if (it == g_i.map_refresh_id.begin() + g_i.n || *it != v) // v is reduced
+        {
+            g_i.recycle();
+            return -1;
+        }
+        int id_v = it - g_i.map_refresh_id.begin();
+        vertices.assign(g_i.map_refresh_id.begin(), g_i.map_refresh_id.begin() + g_i.n);
+        g.init_from_CSR(vertices, g_i.pstart, g_i.edge_to);
+        // strong_reduce stops when each edge (u,v) has triangles(u,v)+2k>lb, which edge_reduction can skip
+        g.second_order_lb = lb;
+        g_i.recycle();
+        return id_v;
     }
     /**
      * @brief plex=S
@@ -541,6 +891,15 @@ public:
                 solution.insert(v);
             solution = ptr_g->get_ori_vertices(solution);
             assert(solution.size() == lb);
+#ifdef PIPELINE_IE
+            shared_lb.store(lb);
+#endif
+            if (is_target_reached())
+                stopped = true; // the rest of G_input is not searched, so it needs no reduction
+#ifdef BACKGROUND_CTCP
+            else
+                start_background_CTCP();
+#endif
             printf("Find a larger plex : %d\n", sz);
             fflush(stdout);
         }
@@ -561,6 +920,15 @@ public:
                 solution.insert(v);
             solution = ptr_g->get_ori_vertices(solution);
             assert(solution.size() == lb);
+#ifdef PIPELINE_IE
+            shared_lb.store(lb);
+#endif
+            if (is_target_reached())
+                stopped = true; // the rest of G_input is not searched, so it needs no reduction
+#ifdef BACKGROUND_CTCP
+            else
+                start_background_CTCP();
+#endif
             printf("Find a larger plex : %d\n", sz);
             fflush(stdout);
         }
@@ -573,7 +941,7 @@ public:
     {
         for (int v : S)
         {
-            loss_cnt[v] = non_A[v].intersect(S); // v∈S, delta[v] = the number of non-neighbors of v in S
+            loss_cnt[v] = S.andnot_count(A[v]); // v∈S, delta[v] = the number of non-neighbors of v in S
             if (loss_cnt[v] > paramK)
             {
                 S_is_plex = false;
@@ -587,7 +955,7 @@ public:
         one_loss_vertices_in_C.clear();
         for (int u : C)
         {
-            loss_cnt[u] = non_A[u].intersect(S); // u∈C, delta[u] = the number of non-neighbors of u in S
+            loss_cnt[u] = S.andnot_count(A[u]); // u∈C, delta[u] = the number of non-neighbors of u in S
             if (loss_cnt[u] >= paramK)           // u has at least k non-neighbors in S, so u can be removed
                 C.reset(u);
             else if (loss_cnt[u] == 1)
@@ -675,8 +1043,8 @@ public:
             else
             {
                 // we consider the non-neighbors of u (excluding u itself)
-                int satisfied_non_neighbor = satisfied.intersect(non_A[u]);
-                int tot_non_neighbor = non_A[u].intersect(V);
+                int satisfied_non_neighbor = satisfied.andnot_count(A[u]);
+                int tot_non_neighbor = V.andnot_count(A[u]);
                 if (satisfied[u])
                 {
                     satisfied_non_neighbor--;
@@ -699,7 +1067,7 @@ public:
                 else
                 {
                     auto non_neighbor = V;
-                    non_neighbor &= non_A[u];
+                    non_neighbor.sub(A[u]);
                     auto &un_satisfied_non_neighbor = non_neighbor;
                     un_satisfied_non_neighbor.sub(satisfied);
                     // assert(un_satisfied_non_neighbor.size() >= 2);
@@ -778,46 +1146,151 @@ public:
         for (int u : S2)
             sup_S2 += paramK - loss_cnt[u];
         auto &non_neighbor_in_S2 = array_n;
-        vector<pii> vertices_in_C;
-        vertices_in_C.reserve(C.size());
+        // sort vertices in C by the number of non-neighbors in S2, which is at most |S2|, so counting sort is enough
+        bucket.assign(S2.size() + 2, 0);
         for (int v : C)
         {
-            non_neighbor_in_S2[v] = S2.intersect(non_A[v]);
-            vertices_in_C.push_back({non_neighbor_in_S2[v], v});
+            non_neighbor_in_S2[v] = S2.andnot_count(A[v]);
+            bucket[non_neighbor_in_S2[v] + 1]++;
         }
-        sort(vertices_in_C.begin(), vertices_in_C.end()); // sort vertices in C by the number of non-neighbors in S2
+        for (int i = 1; i < (int)bucket.size(); i++)
+            bucket[i] += bucket[i - 1];
+        order_C.resize(C.size());
+        for (int v : C) // v is increasing, so the vertices with the same key are sorted by id
+            order_C[bucket[non_neighbor_in_S2[v]]++] = v;
 
+        int S_sz = S.size();
+        if (use_complement)
+        {
+            int m = order_C.size();
+            fenwick_cnt.assign(m + 1, 0);
+            fenwick_sum.assign(m + 1, 0);
+            for (int i = 0; i < m; i++)
+            {
+                pos_in_order[order_C[i]] = i;
+                fenwick_add(i, 1, non_neighbor_in_S2[order_C[i]]);
+            }
+        }
         for (int v : C)
         {
-            int ub = S.size() + 1;
-            int non_neighbor_of_v_in_S = loss_cnt[v]; // |non-N(S, v)|
-            int sup = sup_S2 - S2.intersect(non_A[v]);
-            for (auto &h : vertices_in_C)
+            int sup = sup_S2 - non_neighbor_in_S2[v];
+            bool pruned = use_complement ? kPlexT_prune_by_complement(v, S_sz, sup, C) : kPlexT_prune(v, S_sz, sup, C);
+            assert(pruned == kPlexT_prune(v, S_sz, sup, C));
+            if (pruned)
             {
-                if (ub > lb)
-                    break;
-                if (h.x > sup)
-                    break;
-                int w = h.y;
-                if (w == v || !C[w])
-                    continue;
-                if (non_A[v][w])
+                C.reset(v);
+                if (use_complement)
+                    fenwick_add(pos_in_order[v], -1, -non_neighbor_in_S2[v]);
+            }
+        }
+        reduce_kPlexT_time += t.get_time();
+    }
+    /**
+     * @brief the greedy of reduce_kPlexT for v: we take w in C following order_C to extend S+v,
+     * until ub>lb or the non-neighbors of w in S2 are more than S2 can still support (sup)
+     * @return whether ub<=lb, i.e., v can be removed
+     */
+    bool kPlexT_prune(int v, int S_sz, int sup, Set &C)
+    {
+        auto &non_neighbor_in_S2 = array_n;
+        int ub = S_sz + 1;
+        int non_neighbor_of_v_in_S = loss_cnt[v]; // |non-N(S, v)|
+        for (int w : order_C)
+        {
+            if (ub > lb)
+                break;
+            if (non_neighbor_in_S2[w] > sup)
+                break;
+            if (w == v || !C[w])
+                continue;
+            if (!A[v][w])
+            {
+                if (non_neighbor_of_v_in_S == paramK - 1)
                 {
-                    if (non_neighbor_of_v_in_S == paramK - 1)
-                    {
-                        continue;
-                    }
-                    non_neighbor_of_v_in_S++;
+                    continue;
                 }
-                sup -= h.x;
-                ub++;
+                non_neighbor_of_v_in_S++;
             }
-            if (ub <= lb)
+            sup -= non_neighbor_in_S2[w];
+            ub++;
+        }
+        return ub <= lb;
+    }
+    /**
+     * @brief the same result as kPlexT_prune(), visiting only the sparse non-neighbors of v:
+     * the greedy takes every w in C except v and the non-neighbors of v beyond the first k-1-loss_cnt[v] ones (skipped);
+     * it stops at the first position p with key(p) + (the key sum taken before p) > sup, which is monotone in p,
+     * so v survives iff the position q of the need-th taken vertex passes this test
+     */
+    bool kPlexT_prune_by_complement(int v, int S_sz, int sup, Set &C)
+    {
+        auto &key = array_n;
+        int need = lb - S_sz; // v is removed iff less than $need$ vertices are taken
+        if (need <= 0)
+            return false;
+        auto &skip = skipped_pos;
+        skip.clear();
+        for (int w : non_adj[v])
+            if (C[w])
+                skip.push_back(pos_in_order[w]);
+        sort(skip.begin(), skip.end());
+        int quota = max(paramK - 1 - loss_cnt[v], 0); // the first $quota$ non-neighbors are taken
+        skip.erase(skip.begin(), skip.begin() + min(quota, (int)skip.size()));
+        skip.insert(lower_bound(skip.begin(), skip.end(), pos_in_order[v]), pos_in_order[v]);
+        int m = order_C.size(), cnt, sum;
+        fenwick_query(m, cnt, sum);
+        if (cnt - (int)skip.size() < need)
+            return true;
+        // q = the position of the need-th taken vertex, i.e., the (need + skipped before q)-th vertex in C
+        int target = need, skipped = 0, skipped_sum = 0;
+        int q = fenwick_select(target);
+        while (skipped < (int)skip.size() && skip[skipped] <= q)
+        {
+            skipped_sum += key[order_C[skip[skipped++]]];
+            q = fenwick_select(++target);
+        }
+        fenwick_query(q, cnt, sum);
+        return key[order_C[q]] + sum - skipped_sum > sup;
+    }
+    /**
+     * @return the position of the t-th (t>=1) vertex of order_C that is still in C
+     */
+    inline int fenwick_select(int t)
+    {
+        int pos = 0, m = fenwick_cnt.size() - 1;
+        int step = 1;
+        while (step * 2 <= m)
+            step <<= 1;
+        for (; step; step >>= 1)
+            if (pos + step <= m && fenwick_cnt[pos + step] < t)
             {
-                C.reset(v);
+                pos += step;
+                t -= fenwick_cnt[pos];
             }
+        return pos;
+    }
+    /**
+     * @brief the position i of order_C: count += c, key sum += k
+     */
+    inline void fenwick_add(int i, int c, int k)
+    {
+        for (i++; i < (int)fenwick_cnt.size(); i += i & -i)
+        {
+            fenwick_cnt[i] += c;
+            fenwick_sum[i] += k;
+        }
+    }
+    /**
+     * @brief the count and the key sum of the positions [0, i) that are still in C
+     */
+    inline void fenwick_query(int i, int &cnt, int &sum)
+    {
+        cnt = sum = 0;
+        for (; i > 0; i -= i & -i)
+        {
+            cnt += fenwick_cnt[i];
+            sum += fenwick_sum[i];
         }
-        reduce_kPlexT_time += t.get_time();
     }
     /**
      * @brief generate two sub-branches: one includes pivot and the other excludes pivot
@@ -969,17 +1442,24 @@ public:
         int S_sz = S.size();
         if (N_v.size() > paramK - S.size())
         {
+            int N_v_size = N_v.size();
             for (int u : C)
             {
-                int common_neighbor = N_v.intersect(A[u]);
                 int loss_v = loss_cnt[v] + (!A[v][u]);
                 int loss_u = loss_cnt[u] + 1;
-                int ub = common_neighbor + S_sz + 1 + (paramK - loss_v) + (paramK - loss_u);
-                if (ub <= lb)
+                // ub = common_neighbor + S_sz + 1 + (paramK - loss_v) + (paramK - loss_u) <= lb
+                // <==> common_neighbor <= max_common, so we intersect N_v and A[u] only if the result matters
+                int max_common = lb - (S_sz + 1 + (paramK - loss_v) + (paramK - loss_u));
+                if (max_common < 0)
+                    continue;
+                if (max_common >= N_v_size || N_v.intersect(A[u]) <= max_common)
                 {
                     C.reset(u);
                     if (N_v[u])
+                    {
                         N_v.reset(u);
+                        N_v_size--;
+                    }
                 }
             }
         }
@@ -995,37 +1475,33 @@ public:
     }
     /**
      * @brief partition ub without reduction rules
+     * we continue the partition of the last round of AltRB (called right before): Pi_v for v in useful_S are kept,
+     * AltRB_C is Pi_0 where the vertices reduced by AltRB are already removed, and we go on partitioning with AltRB_S;
+     * loss_cnt[v] for v in S is up to date, as S is not changed since the last round
      */
-    int only_part_UB(Set &S, Set &C, int u = -1)
+    int only_part_UB(Set &S, Set &C)
     {
         Timer part_timer;
-        // auto &loss = deg;
-        auto &loss = array_n;
+        auto &loss = loss_cnt;
+        auto &copy_S = AltRB_S;
+        auto &copy_C = AltRB_C;
+        int ub = AltRB_ub;
+#ifndef NDEBUG
         for (int v : S)
-            loss[v] = non_A[v].intersect(S);
-        auto copy_S = S;
-        auto copy_C = C;
-        int S_sz = S.size();
-        int ub = S_sz;
-        // we will utilize Pi_u
-        if (u != -1)
-        {
-            int sz = non_A[u].intersect(copy_C);
-            int cnt = paramK - loss[u];
-            copy_S.reset(u);
-            ub += cnt;
-            copy_C &= A[u];
-        }
+            assert(loss[v] == S.andnot_count(A[v]));
+        for (int u : copy_C)
+            assert(C[u]);
+#endif
         for (int v : copy_S)
         {
-            one_loss_non_neighbor_cnt[v] = non_A[v].intersect(one_loss_vertices_in_C);
+            one_loss_non_neighbor_cnt[v] = one_loss_vertices_in_C.andnot_count(A[v]);
         }
         while (copy_S.size())
         {
             int sel = -1, size = 0, ub_cnt = 0;
             for (int v : copy_S)
             {
-                int sz = non_A[v].intersect(copy_C);
+                int sz = copy_C.andnot_count(A[v]);
                 int cnt = (paramK - loss[v]);
                 if (sz <= cnt) // Pi_i is useless
                 {
@@ -1033,7 +1509,7 @@ public:
                 }
                 else
                 {
-                    // int one_loss_cnt = non_A[v].intersect(one_loss_vertices_in_C);
+                    // int one_loss_cnt = one_loss_vertices_in_C.andnot_count(A[v]);
                     int one_loss_cnt = one_loss_non_neighbor_cnt[v];
                     if (one_loss_cnt >= cnt)
                     {
@@ -1060,7 +1536,7 @@ public:
         // now copy_C = Pi_0
         auto &Pi_0 = copy_C;
         int ret = ub + Pi_0.size();
-        if (u == -1 && ret == lb + 1 && Pi_0.size())
+        if (ret == lb + 1 && Pi_0.size())
         {
             S |= Pi_0;
             C ^= Pi_0;
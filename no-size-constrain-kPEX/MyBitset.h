@@ -2,10 +2,77 @@
 #define MY_BITSET_H
 
 #include "Utility.h"
+#include <sys/mman.h> // madvise
+
+// a bitset with less than 64*SMALL_BITSET_WORDS bits is stored inside the object
+#define SMALL_BITSET_WORDS 8
+// at most SLAB_POOL_SIZE free slabs of AdjacentMatrix are kept by each thread
+#define SLAB_POOL_SIZE 4
+// slabs larger than this are aligned to it and advised to use huge pages
+#define SLAB_HUGE_PAGE_BYTES (2UL << 20)
+
+/**
+ * @brief bit-operations on W words; W is known at compile time so that the loops are fully unrolled
+ */
+template <int W>
+struct FixedWords
+{
+    static inline int count(const uint64_t *a)
+    {
+        int ret = 0;
+        for (int i = 0; i < W; i++)
+            ret += __builtin_popcountll(a[i]);
+        return ret;
+    }
+    static inline int intersect(const uint64_t *a, const uint64_t *b)
+    {
+        int ret = 0;
+        for (int i = 0; i < W; i++)
+            ret += __builtin_popcountll(a[i] & b[i]);
+        return ret;
+    }
+    static inline int andnot_count(const uint64_t *a, const uint64_t *b)
+    {
+        int ret = 0;
+        for (int i = 0; i < W; i++)
+            ret += __builtin_popcountll(a[i] & ~b[i]);
+        return ret;
+    }
+    static inline int intersect(const uint64_t *a, const uint64_t *b, const uint64_t *c)
+    {
+        int ret = 0;
+        for (int i = 0; i < W; i++)
+            ret += __builtin_popcountll(a[i] & b[i] & c[i]);
+        return ret;
+    }
+    static inline void and_with(uint64_t *a, const uint64_t *b)
+    {
+        for (int i = 0; i < W; i++)
+            a[i] &= b[i];
+    }
+    static inline void or_with(uint64_t *a, const uint64_t *b)
+    {
+        for (int i = 0; i < W; i++)
+            a[i] |= b[i];
+    }
+    static inline void xor_with(uint64_t *a, const uint64_t *b)
+    {
+        for (int i = 0; i < W; i++)
+            a[i] ^= b[i];
+    }
+    static inline void sub(uint64_t *a, const uint64_t *b)
+    {
+        for (int i = 0; i < W; i++)
+            a[i] &= ~b[i];
+    }
+};
 
 /**
  * @brief bitset, which supports & | bit-operation in O(n/64).
  * we provide an iterator too
+ * if n+1 <= SMALL_BITSET_WORDS, the words are stored in local[] (no heap allocation when copying),
+ * and the operations are unrolled for 1, 2, 4 or 8 words, i.e., the range is at most 64, 128, 256 or 512
+ * a bitset can also be a view of words owned by others (see attach), e.g., a row of AdjacentMatrix
  */
 class MyBitset
 {
@@ -17,51 +84,116 @@ public:
     uint64_t *buf;
     int sz;
     bool sz_changed;
+    int fixed_w;                         // 1, 2, 4, 8 if buf has exactly fixed_w words; otherwise 0
+    bool own_buf;                        // buf is allocated on the heap by this object
+    uint64_t local[SMALL_BITSET_WORDS]; // the words beyond n are always 0, so we can operate on fixed_w words
 
-    MyBitset() : n(0), m(0), capacity(0), buf(nullptr), sz(0), sz_changed(false) {}
+    MyBitset() : n(0), m(0), capacity(0), buf(nullptr), sz(0), sz_changed(false), fixed_w(0), own_buf(false) {}
 
     MyBitset(int _range) : range(_range), n(_range >> 6), m(_range & 63), capacity(_range), sz(0), sz_changed(false)
     {
-        buf = new uint64_t[n + 1];
+        alloc();
         memset(buf, 0, sizeof(uint64_t) * (n + 1));
     }
 
     MyBitset(const MyBitset &other) : range(other.range), n(other.n), m(other.m), capacity(other.capacity),
                                       sz(other.sz), sz_changed(other.sz_changed)
     {
-        buf = new uint64_t[n + 1];
-        memcpy(buf, other.buf, sizeof(uint64_t) * (n + 1));
+        alloc();
+        if (other.buf != nullptr)
+            memcpy(buf, other.buf, sizeof(uint64_t) * (n + 1));
+    }
+
+    MyBitset(MyBitset &&other) noexcept : range(other.range), n(other.n), m(other.m), capacity(other.capacity),
+                                          sz(other.sz), sz_changed(other.sz_changed), fixed_w(other.fixed_w), own_buf(other.own_buf)
+    {
+        if (other.buf == other.local)
+        {
+            buf = local;
+            memcpy(local, other.local, sizeof(local));
+        }
+        else
+            buf = other.buf;
+        other.buf = nullptr;
+        other.own_buf = false;
     }
 
     MyBitset &operator=(const MyBitset &other)
     {
         if (this == &other)
             return *this;
-        if (buf != nullptr)
-        {
-            delete[] buf;
-            buf = nullptr;
-        }
+        if (buf != nullptr && n != other.n) // the buffer can be reused if the size is the same
+            release();
         range = other.range;
         n = other.n;
         m = other.m;
         sz = other.sz;
         capacity = other.capacity;
         sz_changed = other.sz_changed;
-        buf = new uint64_t[n + 1];
+        if (buf == nullptr)
+            alloc();
         memcpy(buf, other.buf, sizeof(uint64_t) * (n + 1));
         return *this;
     }
 
     ~MyBitset()
     {
-        if (buf != nullptr)
+        release();
+    }
+
+    /**
+     * @brief point buf to local[] or the heap according to n
+     */
+    void alloc()
+    {
+        if (n < SMALL_BITSET_WORDS)
         {
-            delete[] buf;
-            buf = nullptr;
+            buf = local;
+            fixed_w = words_of(n + 1);
+            own_buf = false;
+            memset(local, 0, sizeof(local));
+        }
+        else
+        {
+            buf = new uint64_t[n + 1];
+            fixed_w = 0;
+            own_buf = true;
         }
     }
 
+    void release()
+    {
+        if (own_buf)
+            delete[] buf;
+        buf = nullptr;
+        own_buf = false;
+    }
+
+    /**
+     * @return the number of words a bitset with w valid words operates on, i.e., 1, 2, 4, 8 or w itself
+     */
+    static inline int words_of(int w)
+    {
+        if (w > SMALL_BITSET_WORDS)
+            return w;
+        return w <= 1 ? 1 : (w <= 2 ? 2 : (w <= 4 ? 4 : 8));
+    }
+
+    /**
+     * @brief make this a view of words[0, words_of(_range/64+1)), which must be zero beyond the range and outlive this
+     */
+    void attach(uint64_t *words, int _range)
+    {
+        release();
+        range = capacity = _range;
+        n = _range >> 6;
+        m = _range & 63;
+        buf = words;
+        sz = 0;
+        sz_changed = false;
+        fixed_w = n < SMALL_BITSET_WORDS ? words_of(n + 1) : 0;
+    }
+
     void clear()
     {
         memset(buf, 0, sizeof(uint64_t) * (n + 1));
@@ -114,22 +246,55 @@ public:
     void operator&=(const MyBitset &other)
     {
         assert(n == other.n);
-        std::transform(buf, buf + n + 1, other.buf, buf, std::bit_and<uint64_t>());
         sz_changed = true;
+        switch (fixed_w)
+        {
+        case 1:
+            return FixedWords<1>::and_with(buf, other.buf);
+        case 2:
+            return FixedWords<2>::and_with(buf, other.buf);
+        case 4:
+            return FixedWords<4>::and_with(buf, other.buf);
+        case 8:
+            return FixedWords<8>::and_with(buf, other.buf);
+        }
+        std::transform(buf, buf + n + 1, other.buf, buf, std::bit_and<uint64_t>());
     }
 
     void operator|=(const MyBitset &other)
     {
         assert(n == other.n);
-        std::transform(buf, buf + n + 1, other.buf, buf, std::bit_or<uint64_t>());
         sz_changed = true;
+        switch (fixed_w)
+        {
+        case 1:
+            return FixedWords<1>::or_with(buf, other.buf);
+        case 2:
+            return FixedWords<2>::or_with(buf, other.buf);
+        case 4:
+            return FixedWords<4>::or_with(buf, other.buf);
+        case 8:
+            return FixedWords<8>::or_with(buf, other.buf);
+        }
+        std::transform(buf, buf + n + 1, other.buf, buf, std::bit_or<uint64_t>());
     }
 
     void operator^=(const MyBitset &other)
     {
         assert(n == other.n);
-        std::transform(buf, buf + n + 1, other.buf, buf, std::bit_xor<uint64_t>());
         sz_changed = true;
+        switch (fixed_w)
+        {
+        case 1:
+            return FixedWords<1>::xor_with(buf, other.buf);
+        case 2:
+            return FixedWords<2>::xor_with(buf, other.buf);
+        case 4:
+            return FixedWords<4>::xor_with(buf, other.buf);
+        case 8:
+            return FixedWords<8>::xor_with(buf, other.buf);
+        }
+        std::transform(buf, buf + n + 1, other.buf, buf, std::bit_xor<uint64_t>());
     }
 
     bool operator==(const MyBitset &other) const
@@ -167,17 +332,40 @@ public:
     // a.sub(b) <==> a= a - a ∩ b
     void sub(const MyBitset &other)
     {
+        sz_changed = true;
+        switch (fixed_w)
+        {
+        case 1:
+            return FixedWords<1>::sub(buf, other.buf);
+        case 2:
+            return FixedWords<2>::sub(buf, other.buf);
+        case 4:
+            return FixedWords<4>::sub(buf, other.buf);
+        case 8:
+            return FixedWords<8>::sub(buf, other.buf);
+        }
         for (int i = 0; i <= n; i++)
         {
             buf[i] &= ~other.buf[i];
         }
-        sz_changed = true;
     }
 
     int size()
     {
         if (!sz_changed)
             return sz;
+        sz_changed = false;
+        switch (fixed_w)
+        {
+        case 1:
+            return sz = FixedWords<1>::count(buf);
+        case 2:
+            return sz = FixedWords<2>::count(buf);
+        case 4:
+            return sz = FixedWords<4>::count(buf);
+        case 8:
+            return sz = FixedWords<8>::count(buf);
+        }
         sz = std::accumulate(buf, buf + n + 1, 0, [](int sum, uint64_t val)
                              { return sum + __builtin_popcountll(val); });
         sz_changed = false;
@@ -186,12 +374,54 @@ public:
 
     int intersect(const MyBitset &other) const
     {
+        switch (fixed_w)
+        {
+        case 1:
+            return FixedWords<1>::intersect(buf, other.buf);
+        case 2:
+            return FixedWords<2>::intersect(buf, other.buf);
+        case 4:
+            return FixedWords<4>::intersect(buf, other.buf);
+        case 8:
+            return FixedWords<8>::intersect(buf, other.buf);
+        }
         return std::inner_product(buf, buf + n + 1, other.buf, 0, std::plus<int>(), [](uint64_t a, uint64_t b)
                                   { return __builtin_popcountll(a & b); });
     }
 
+    /**
+     * @return |this - other|, i.e., this->intersect(~other) without materializing ~other
+     */
+    int andnot_count(const MyBitset &other) const
+    {
+        switch (fixed_w)
+        {
+        case 1:
+            return FixedWords<1>::andnot_count(buf, other.buf);
+        case 2:
+            return FixedWords<2>::andnot_count(buf, other.buf);
+        case 4:
+            return FixedWords<4>::andnot_count(buf, other.buf);
+        case 8:
+            return FixedWords<8>::andnot_count(buf, other.buf);
+        }
+        return std::inner_product(buf, buf + n + 1, other.buf, 0, std::plus<int>(), [](uint64_t a, uint64_t b)
+                                  { return __builtin_popcountll(a & ~b); });
+    }
+
     int intersect(const MyBitset &a, const MyBitset &b) const
     {
+        switch (fixed_w)
+        {
+        case 1:
+            return FixedWords<1>::intersect(buf, a.buf, b.buf);
+        case 2:
+            return FixedWords<2>::intersect(buf, a.buf, b.buf);
+        case 4:
+            return FixedWords<4>::intersect(buf, a.buf, b.buf);
+        case 8:
+            return FixedWords<8>::intersect(buf, a.buf, b.buf);
+        }
         int ret = 0;
         for (int i = 0; i <= n; i++)
             ret += __builtin_popcountll((buf[i] & a.buf[i]) & b.buf[i]);
@@ -289,28 +519,185 @@ std::ostream &operator<<(std::ostream &out, MyBitset &s)
     return out;
 }
 
+/**
+ * @brief 64-byte aligned memory for AdjacentMatrix; each thread keeps a few freed slabs so that
+ * consecutive matrices (e.g., one per g_i in IE) reuse them instead of calling the allocator
+ */
+class SlabPool
+{
+    vector<pair<size_t, uint64_t *>> free_slabs; // (capacity in words, slab)
+
+    SlabPool() { alive() = true; }
+
+    static bool &alive()
+    {
+        static thread_local bool flag = false;
+        return flag;
+    }
+
+    static SlabPool &local_pool()
+    {
+        static thread_local SlabPool pool;
+        return pool;
+    }
+
+    static uint64_t *allocate(size_t &words)
+    {
+        size_t bytes = words * sizeof(uint64_t);
+        size_t align = 64;
+        if (bytes >= SLAB_HUGE_PAGE_BYTES)
+        {
+            align = SLAB_HUGE_PAGE_BYTES;
+            bytes = (bytes + align - 1) / align * align;
+        }
+        void *p = nullptr;
+        if (posix_memalign(&p, align, bytes) != 0)
+            throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+        if (align == SLAB_HUGE_PAGE_BYTES)
+            madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+        words = bytes / sizeof(uint64_t);
+        return (uint64_t *)p;
+    }
+
+public:
+    ~SlabPool()
+    {
+        for (auto &h : free_slabs)
+            free(h.y);
+        alive() = false;
+    }
+
+    /**
+     * @brief get a slab with at least words words; cap is set to its real capacity
+     */
+    static uint64_t *acquire(size_t words, size_t &cap)
+    {
+        auto &slabs = local_pool().free_slabs;
+        int best = -1;
+        for (int i = 0; i < slabs.size(); i++)
+            if (slabs[i].x >= words && (best == -1 || slabs[i].x < slabs[best].x))
+                best = i;
+        if (best == -1)
+        {
+            cap = words;
+            return allocate(cap);
+        }
+        cap = slabs[best].x;
+        uint64_t *ret = slabs[best].y;
+        slabs[best] = slabs.back();
+        slabs.pop_back();
+        return ret;
+    }
+
+    /**
+     * @brief return a slab; the smallest one is freed if more than SLAB_POOL_SIZE slabs are kept
+     */
+    static void give_back(uint64_t *slab, size_t cap)
+    {
+        if (!alive()) // the pool of this thread is destroyed, e.g., when destructing global objects
+        {
+            free(slab);
+            return;
+        }
+        auto &slabs = local_pool().free_slabs;
+        slabs.push_back({cap, slab});
+        if (slabs.size() > SLAB_POOL_SIZE)
+        {
+            int smallest = 0;
+            for (int i = 1; i < slabs.size(); i++)
+                if (slabs[i].x < slabs[smallest].x)
+                    smallest = i;
+            free(slabs[smallest].y);
+            slabs[smallest] = slabs.back();
+            slabs.pop_back();
+        }
+    }
+};
+
 /**
  * @brief use n*n bits to store a graph
+ * all rows are stored in one slab with a fixed stride, and A[u] is a view of the u-th row
  */
 class AdjacentMatrix
 {
 public:
     int n;
+    int stride;      // words per row, a multiple of 8 (64 bytes) if the row is longer than SMALL_BITSET_WORDS
+    uint64_t *slab;  // row u is slab[u*stride, (u+1)*stride)
+    size_t slab_cap; // capacity of slab in words
     vector<MyBitset> A;
 
-    AdjacentMatrix() {}
-    AdjacentMatrix(int _n) : n(_n), A(_n, MyBitset(_n))
+    AdjacentMatrix() : n(0), stride(0), slab(nullptr), slab_cap(0) {}
+    AdjacentMatrix(int _n) : n(0), stride(0), slab(nullptr), slab_cap(0)
     {
+        reshape(_n);
+        memset(slab, 0, sizeof(uint64_t) * n * stride);
+    }
+    AdjacentMatrix(const AdjacentMatrix &other) : n(0), stride(0), slab(nullptr), slab_cap(0)
+    {
+        *this = other;
+    }
+    AdjacentMatrix(AdjacentMatrix &&other) noexcept : n(0), stride(0), slab(nullptr), slab_cap(0)
+    {
+        swap(other);
+    }
+    ~AdjacentMatrix()
+    {
+        if (slab != nullptr)
+            SlabPool::give_back(slab, slab_cap);
     }
-    ~AdjacentMatrix() {}
 
     AdjacentMatrix &operator=(const AdjacentMatrix &other)
     {
-        n = other.n;
-        A = other.A;
+        if (this == &other)
+            return *this;
+        reshape(other.n);
+        memcpy(slab, other.slab, sizeof(uint64_t) * n * stride);
+        for (int i = 0; i < n; i++)
+        {
+            A[i].sz = other.A[i].sz;
+            A[i].sz_changed = other.A[i].sz_changed;
+        }
+        return *this;
+    }
+
+    AdjacentMatrix &operator=(AdjacentMatrix &&other) noexcept
+    {
+        swap(other);
         return *this;
     }
 
+    void swap(AdjacentMatrix &other)
+    {
+        std::swap(n, other.n);
+        std::swap(stride, other.stride);
+        std::swap(slab, other.slab);
+        std::swap(slab_cap, other.slab_cap);
+        A.swap(other.A);
+    }
+
+    /**
+     * @brief let the matrix have _n rows; the slab is reused if it is large enough, and the content is undefined
+     */
+    void reshape(int _n)
+    {
+        int row_words = (_n >> 6) + 1;
+        stride = row_words <= SMALL_BITSET_WORDS ? MyBitset::words_of(row_words) : (row_words + 7) / 8 * 8;
+        size_t words = (size_t)_n * stride;
+        if (words > slab_cap || slab == nullptr)
+        {
+            if (slab != nullptr)
+                SlabPool::give_back(slab, slab_cap);
+            slab = SlabPool::acquire(words == 0 ? 1 : words, slab_cap);
+        }
+        n = _n;
+        A.resize(n);
+        for (int i = 0; i < n; i++)
+            A[i].attach(slab + (size_t)i * stride, n);
+    }
+
     bool operator==(const AdjacentMatrix &other) const
     {
         for (int i = 0; i < n; i++)
@@ -333,7 +720,7 @@ public:
 
     inline bool exist_edge(int a, int b) const
     {
-        return A[a][b];
+        return (slab[(size_t)a * stride + (b >> 6)] >> (b & 63)) & 1;
     }
 
     MyBitset &operator[](int x)
@@ -359,16 +746,17 @@ public:
 
     void clear()
     {
+        memset(slab, 0, sizeof(uint64_t) * n * stride);
         for (auto &s : A)
-            s.clear();
+            s.sz = 0, s.sz_changed = false;
     }
 
     double density()
     {
-        int m = 0;
+        ll m = 0;
         for (auto &h : A)
             m += h.size();
-        return 1.0 * m / (n * (n - 1));
+        return 1.0 * m / ((double)n * (n - 1));
     }
 };
 
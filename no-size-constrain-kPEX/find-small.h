@@ -3,8 +3,15 @@
 
 #include "Graph.h"
 
+// if the reduced graph has at most SMALL_MATRIX_MAX_N vertices, we search it with the adjacent matrix (at most 32MB)
+#ifndef SMALL_MATRIX_MAX_N
+#define SMALL_MATRIX_MAX_N 16384
+#endif
+
 /**
  * @brief find maximum k-plex of size at most 2k-2
+ * for each lb (from 2k-3 down to |solution|), the graph is induced from base_g by the core numbers computed once;
+ * then we search it with bitsets if it is small enough, otherwise with adjacent lists
  */
 class Solver_small
 {
@@ -24,33 +31,112 @@ public:
     vector<int> deg;               // degree in G[S+C]
     vector<int> neighbor_cnt_in_S; // |N(u)\cap S|
 
-    Solver_small(string graph_path, const set<ui> &s, int paramK) : solution(s), k(paramK)
+    vector<ui> core;      // core[u] is the core number of u in base_g
+    Graph_adjacent g_adj; // the adjacent matrix of g, used by bnb_matrix()
+    ll dfs_cnt;
+    double deadline; // the search stops once get_system_time_microsecond() passes it; 0 means no time limit
+    bool timed_out;  // the search stopped at the deadline, so solution may be not maximum
+
+    // the buffers of kPlexT_reduce_matrix(), sized once for each g so that a search node allocates nothing
+    MyBitset S2;
+    vector<int> non_neighbor_cnt_in_S2; // only read for the vertices of C, which are written first
+    vector<vector<int>> bucket;
+    vector<int> order;
+
+    Solver_small(const Graph &input, const set<ui> &s, int paramK, double _deadline = 0)
+        : base_g(input), solution(s), k(paramK), dfs_cnt(0), deadline(_deadline), timed_out(false)
     {
-        // reload graph
-        base_g.readFromFile(graph_path);
         // sort vertices according to degeneracy order
         base_g.degeneracy_and_reduce(solution.size(), &solution);
         printf("for small search: n= %u m= %u lb= %u\n", base_g.n, base_g.m, solution.size());
+        compute_core();
     }
     ~Solver_small() {}
 
+    /**
+     * @brief whether the deadline is passed; once it is, the search returns with the best solution found so far
+     */
+    bool should_stop()
+    {
+        if (!timed_out && deadline > 0 && get_system_time_microsecond() > deadline)
+            timed_out = true;
+        return timed_out;
+    }
+
+    /**
+     * @brief core[u] = the core number of u in base_g
+     * the weak reduction of lb keeps exactly the vertices with core[u]+k>lb, so we peel base_g only once for all lb
+     */
+    void compute_core()
+    {
+        ui n = base_g.n;
+        core.assign(n, 0);
+        if (n == 0)
+            return;
+        vector<ui> d(base_g.d, base_g.d + n);
+        vector<bool> rm(n, 0);
+        LinearHeap heap(n, n, d);
+        ui max_core = 0;
+        while (heap.sz)
+        {
+            ui u = heap.get_min_node();
+            heap.delete_node(u);
+            rm[u] = 1;
+            max_core = max(max_core, d[u]);
+            core[u] = max_core;
+            for (ui i = base_g.pstart[u]; i < base_g.pstart[u + 1]; i++)
+            {
+                ui v = base_g.edge_to[i];
+                if (!rm[v])
+                    heap.decrease(--d[v], v);
+            }
+        }
+    }
+
+    /**
+     * @brief g = the subgraph of base_g induced by {u | core[u]+k>lb}, i.e., base_g after weak reduction of lb
+     */
+    void induce_by_core(int lb)
+    {
+        vector<int> ids, inv(base_g.n, -1);
+        for (ui u = 0; u < base_g.n; u++)
+            if (core[u] + k > lb)
+            {
+                inv[u] = ids.size();
+                ids.push_back(base_g.map_refresh_id[u]);
+            }
+        vector<pii> edges;
+        for (ui u = 0; u < base_g.n; u++)
+        {
+            if (inv[u] == -1)
+                continue;
+            for (ui i = base_g.pstart[u]; i < base_g.pstart[u + 1]; i++)
+            {
+                ui v = base_g.edge_to[i];
+                if (inv[v] != -1)
+                    edges.push_back({inv[u], inv[v]});
+            }
+        }
+        g = Graph(ids, edges);
+    }
+
     /**
      * @brief start to search
      */
     void start_search()
     {
-        for (lb = 2 * k - 3; lb >= solution.size(); lb--)
+        for (lb = 2 * k - 3; lb >= solution.size() && !should_stop(); lb--)
         {
             printf("now given lb= %d ,focus on lb+1 ", lb);
             // aim: verify whether exists kplex of size lb+1
-            g = base_g;
+            induce_by_core(lb);
             set<ui> temp;
             // heuristic again
             g.degeneracy_and_reduce(lb, &temp);
             printf("n= %u m= %u\n", g.n, g.m);
             assert(temp.size() <= lb + 1);
-            if (temp.size() != lb + 1)
-                g.strong_heuris(lb, temp, 3e6); // time-limit = 3s
+            if (temp.size() != lb + 1) // time-limit = 3s, or the time left
+                g.strong_heuris(lb, temp, deadline > 0 ? min(3e6, max(1.0, deadline - get_system_time_microsecond())) : 3e6);
             assert(temp.size() <= lb + 1);
             if (temp.size() > solution.size())
             {
@@ -58,8 +144,13 @@ public:
                 if (lb < solution.size())
                     break;
             }
-            if (g.n <= lb)
+            if (g.n <= lb || should_stop())
+                continue;
+            if (g.n <= SMALL_MATRIX_MAX_N)
+            {
+                search_with_matrix();
                 continue;
+            }
             d = g.d;
             pstart = g.pstart;
             edge_to = g.edge_to;
@@ -82,6 +173,219 @@ public:
                 neighbor_cnt_in_S[u] = 0;
             bnb();
         }
+        printf("small search: dfs_cnt= %lld\n", dfs_cnt);
+    }
+
+    /**
+     * @brief build the adjacent matrix of g and then search it with bnb_matrix()
+     */
+    void search_with_matrix()
+    {
+        vector<int> ids(g.n);
+        vector<pii> edges;
+        for (ui u = 0; u < g.n; u++)
+        {
+            ids[u] = g.map_refresh_id[u];
+            for (ui i = g.pstart[u]; i < g.pstart[u + 1]; i++)
+                edges.push_back({u, g.edge_to[i]});
+        }
+        g_adj = Graph_adjacent(ids, edges);
+        S2 = MyBitset(g.n);
+        non_neighbor_cnt_in_S2.resize(g.n);
+        MyBitset S(g.n), C(g.n);
+        C.flip();
+        bnb_matrix(S, C);
+    }
+
+    /**
+     * @brief the same branch-and-bound as bnb(), where S, C and the neighbors are bitsets of g_adj
+     * the branch of removing pivot from C is done in the loop, so the recursion depth is at most |S|
+     */
+    void bnb_matrix(MyBitset &S, MyBitset &C)
+    {
+        auto &A = g_adj.adj_matrix;
+        if (S.size() > solution.size()) // update solution
+            update_solution(S, nullptr);
+        int S_sz = S.size();
+        while (true)
+        {
+            dfs_cnt++;
+            if (solution.size() > lb || should_stop())
+                return;
+            // reduce C: remove u if S+u is not a k-plex or d(u)+k<=lb
+            for (int v : S)
+                if (A[v].intersect(S) + k == S_sz) // v has k non-neighbors in S
+                    C &= A[v];
+            auto V = S;
+            V |= C;
+            bool reduced = true;
+            while (reduced)
+            {
+                reduced = false;
+                for (int u : C)
+                {
+                    if (A[u].intersect(S) + k < S_sz + 1 || A[u].intersect(V) + k <= lb)
+                    {
+                        C.reset(u);
+                        V.reset(u);
+                        reduced = true;
+                    }
+                }
+            }
+            kPlexT_reduce_matrix(S, C, V);
+
+            // ub = min(|S|+|C|, d(v)+k for v in S)
+            int V_sz = V.size();
+            int ub = V_sz, sel = -1;
+            for (int v : S)
+            {
+                int d_v = A[v].intersect(V);
+                if (d_v + k <= ub)
+                {
+                    ub = d_v + k;
+                    sel = v;
+                }
+            }
+            if (ub <= lb)
+                return;
+            if (ub == lb + 1 && sel != -1) // the neighbors of sel in C must be included
+            {
+                auto N_C = C;
+                N_C &= A[sel];
+                if (N_C.size())
+                {
+                    auto new_S = S, new_C = C;
+                    new_S |= N_C;
+                    new_C.sub(N_C);
+                    if (is_kPlex(new_S))
+                        bnb_matrix(new_S, new_C);
+                    return;
+                }
+            }
+
+            // select the vertex with minimum degree in G[S+C]
+            int pivot = -1, min_d = INF;
+            for (int u : C)
+            {
+                int d_u = A[u].intersect(V);
+                if (d_u < min_d)
+                {
+                    pivot = u;
+                    min_d = d_u;
+                }
+            }
+            assert(pivot != -1);
+            if (min_d + k >= V_sz && is_kPlex(V)) // S+C is k-plex
+            {
+                if (V_sz > solution.size())
+                    update_solution(S, &C);
+                return;
+            }
+
+            // branch 1: add pivot to S
+            {
+                auto new_S = S, new_C = C;
+                new_S.set(pivot);
+                new_C.reset(pivot);
+                if (is_kPlex(new_S))
+                    bnb_matrix(new_S, new_C);
+            }
+            // branch 2: remove pivot from C
+            C.reset(pivot);
+        }
+    }
+
+    /**
+     * @brief solution = S (+C)
+     */
+    void update_solution(MyBitset &S, MyBitset *C)
+    {
+        solution.clear();
+        for (int v : S)
+            solution.insert(g_adj.vertex_id[v]);
+        if (C != nullptr)
+            for (int v : *C)
+                solution.insert(g_adj.vertex_id[v]);
+        printf("larger lb= %u \n", solution.size());
+    }
+
+    /**
+     * @return whether G[P] is a k-plex
+     */
+    bool is_kPlex(MyBitset &P)
+    {
+        auto &A = g_adj.adj_matrix;
+        int sz = P.size();
+        for (int v : P)
+            if (A[v].intersect(P) + k < sz)
+                return false;
+        return true;
+    }
+
+    /**
+     * @brief Alg.Reduce in kPlexT, see kPlexT_reduce()
+     * @param V V=S+C, and the removed vertices are also reset in V
+     */
+    void kPlexT_reduce_matrix(MyBitset &S, MyBitset &C, MyBitset &V)
+    {
+        int S_sz = S.size();
+        if (S_sz <= 1)
+            return;
+        auto &A = g_adj.adj_matrix;
+        int V_sz = V.size();
+        S2.clear();
+        int sup_S2 = 0;
+        for (int u : S)
+        {
+            int nS = A[u].intersect(S);
+            if (A[u].intersect(V) + k < V_sz)
+            {
+                S2.set(u);
+                sup_S2 += k - (S_sz - nS);
+            }
+        }
+        int S2_sz = S2.size();
+        // sort C by the non-neighbor count in S2 with counting sort
+        if (bucket.size() < S2_sz + 1)
+            bucket.resize(S2_sz + 1);
+        for (int i = 0; i <= S2_sz; i++)
+            bucket[i].clear();
+        order.clear();
+        for (int u : C)
+        {
+            non_neighbor_cnt_in_S2[u] = S2_sz - A[u].intersect(S2);
+            bucket[non_neighbor_cnt_in_S2[u]].push_back(u);
+        }
+        for (int i = 0; i <= S2_sz; i++)
+            order.insert(order.end(), bucket[i].begin(), bucket[i].end());
+        for (int v : order)
+        {
+            int ub = S_sz + 1;
+            int nnv = S_sz - A[v].intersect(S);
+            int sup = sup_S2 - non_neighbor_cnt_in_S2[v];
+            for (int w : order)
+            {
+                if (w == v)
+                    continue;
+                if (non_neighbor_cnt_in_S2[w] > sup || ub > lb)
+                    break;
+                if (!C[w])
+                    continue;
+                if (!A[v][w])
+                {
+                    if (nnv >= k - 1)
+                        continue;
+                    nnv++;
+                }
+                sup -= non_neighbor_cnt_in_S2[w];
+                ub++;
+            }
+            if (ub <= lb)
+            {
+                C.reset(v);
+                V.reset(v);
+            }
+        }
     }
 
     /**
@@ -97,7 +401,7 @@ public:
             assert(solution.size() == S.size());
             printf("larger lb= %u \n", solution.size());
         }
-        if (solution.size() > lb)
+        if (solution.size() > lb || should_stop())
             return;
 
         vector<int> vertex_removed; // store the vertices we removed in current branch
@@ -1,51 +1,9 @@
-#include "Graph.h"
-#include "Branch.h"
+#include "Solver.h"
 
-#ifdef enable_CTCP // the existing heuristic method Degen uses CTCP
-#include "2th-Reduction-CTCP.h"
-#else // use CF-CTCP
-#include "2th-Reduction.h"
-#endif
-
-#include "find-small.h"
-
-string file_path;
-Graph g;
-set<ui> solution;
-double algorithm_start_time, total_heuris_time;
-double FastHeuris_time;
-double StrongHeuris_time;
-double strong_reduce_time;
-int FastHeuris_lb;
-int input_n;
-
-void print_solution()
+void print_solution(set<ui> &solution, int k)
 {
-    if (solution.size() < 2 * paramK - 1)
+    if (solution.size() < 2 * k - 1) // the maximum k-plex is small, see Solver::small_search()
     {
-        // printf("***We can't find a plex larger than 2k-2!! The following is a heuristic solution.\n");
-        // if (solution.size())
-        // {
-        //     print_set(solution);
-        // }
-
-        /**
-         * We can't find a plex larger than 2k-2!
-         * but we have already got a heuristic solution
-         * Then we continue to search maximum k-plex of size > lb = solution.size()
-         */
-        Timer t("small-search");
-        if (solution.size() < 2 * paramK - 2)
-        {
-            lb = solution.size(); // update the global lb
-            Solver_small solver(file_path, solution, paramK);
-            solver.start_search();
-            if (solver.solution.size() > solution.size())
-                solution = solver.solution;
-        }
-        printf("The size is smaller than 2k-1!\n");
-        t.print_time();
-        assert(solution.size() <= 2 * paramK - 2);
         printf("Maximum solution(size= %d ):\n", (int)solution.size());
         print_set(solution);
         fflush(stdout);
@@ -59,213 +17,123 @@ void print_solution()
     fflush(stdout);
 }
 
-void print_heuris_log()
-{
-    puts("*************Heuristic result*************");
-    total_heuris_time = get_system_time_microsecond() - algorithm_start_time;
-    printf("list triangles time: %.4lf s, strong reduce time: %.4lf s\n", list_triangle_time / 1e6, strong_reduce_time / 1e6);
-    printf("total-heuristic-time= %.4lf s, FastHeuris-time= %.4lf s, StrongHeuris-time= %.4lf s\n",
-           total_heuris_time / 1e6, FastHeuris_time / 1e6, StrongHeuris_time / 1e6);
-    printf("lb= %d , FastHeuris-lb= %d \n", lb, FastHeuris_lb);
-    if (solution.size() >= 2 * paramK - 1)
-        assert(solution.size() == lb);
-
-    if (g.n <= lb)
-    {
-        // printf("The heuristic solution is the ground truth!\n");
-        print_solution();
-        puts("------------------{whole procedure: kPEX}---------------------");
-        printf("ground truth= %u , kPEX time: %.4lf s\n\n", solution.size(), (get_system_time_microsecond() - algorithm_start_time) / 1e6);
-        exit(0);
-    }
-}
-
 /**
- * @brief the heuristic stage without StrongHeuris
+ * @return the answer of the decision query "is there a k-plex of at least target vertices"
  */
-void FastHeuris()
+const char *get_answer(const Solver &solver)
 {
-    Timer t("FastHeuris");
-    // degeneracy + weak reduce
-    {
-#ifndef NO_SQRT
-        lb = g.sqrt_degeneracy(&solution);
-        printf("sqrt lb= %d, use time %.4lf s\n", lb, t.get_time() / 1e6);
-#endif
-        lb = max(lb, 2 * paramK - 2); // we only care the solutions with at least 2k-1 vertices
-        lb = max(lb, g.degeneracy_and_reduce(lb, &solution));
-        printf("After degeneracy and weak reduce, n= %u , m= %u , lb= %d , use time %.4lf s\n", g.n, g.m / 2, lb, t.get_time() / 1e6);
-        if (lb >= g.n)
-        {
-            g.n = 0;
-            FastHeuris_lb = lb;
-            FastHeuris_time = t.get_time();
-            print_heuris_log();
-            exit(0);
-        }
-    }
-    FastHeuris_lb = lb;
-
-    // strong reduce: CF-CTCP
-    {
-        Timer start_strong_reduce;
-        Reduction reduce(&g);
-        ui pre_n = g.n;
-        reduce.strong_reduce(lb);
-        printf("Afer strong reduce, n= %u , m= %u, use time %.4lf s\n", g.n, g.m / 2, start_strong_reduce.get_time() / 1e6);
-        strong_reduce_time += start_strong_reduce.get_time();
-
-        if (lb >= g.n)
-        {
-            g.n = 0;
-            FastHeuris_time = t.get_time();
-            print_heuris_log();
-            exit(0);
-        }
-    }
-    FastHeuris_time = t.get_time();
+    if (solver.is_target_reached())
+        return "yes";
+    return solver.is_decided() ? "no" : "unknown";
 }
 
-/**
- * @brief we make more efforts to get better lb and then reduce graph
- */
-void StrongHeuris()
+int main(int argc, char *argv[])
 {
-    int iteration_cnt = 1;
-    double time_limit = FastHeuris_time;
-    time_limit = max(time_limit, 0.5 * 1e6);
-    if (paramK >= 15)
+    if (argc < 3)
     {
-        time_limit = max(time_limit, 1e3 * 1e6);
+        printf("2 params are required !!! \n");
+        printf("usage: ./kPEX graph_path k [--target s] [--anchors v1,v2,...]\n");
+        printf("   or: ./kPEX graph_path k1..k2 [--target s] [--anchors v1,v2,...]\n");
+        printf("--target s: only decide whether there is a k-plex with at least s vertices\n");
+        printf("--anchors v1,v2,...: the maximum k-plex that contains all these vertices\n");
+        exit(1);
     }
-    Timer t_extend("StrongHeuris");
-    while (1)
+    int target = 0;
+    set<ui> anchors;
+    for (int i = 3; i < argc; i++)
     {
-#ifdef NO_STRONG_HEURIS
-        break;
-#endif
-        int extend_lb = 0;
-        if (solution.size() < 2 * paramK - 2) // this means we probably find no larger plex
+        if (strcmp(argv[i], "--target") == 0 && i + 1 < argc)
+            target = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--anchors") == 0 && i + 1 < argc)
         {
-            break;
+            istringstream vs(argv[++i]);
+            string v;
+            while (getline(vs, v, ','))
+                if (v.size())
+                    anchors.insert(stoul(v));
         }
-        extend_lb = g.strong_heuris(lb, solution, time_limit);
-        printf("%dth-StrongHeuris lb= %d\n", iteration_cnt++, extend_lb);
-        if (extend_lb <= lb)
-            break;
-        lb = extend_lb;
-        g.weak_reduce(lb);
-
-        // strong reduce
+        else
         {
-            Timer start_strong_reduce;
-            Reduction reduce(&g);
-            ui pre_n = g.n;
-            reduce.strong_reduce(lb);
-            printf("Afer strong reduce, n= %u , m= %u, use time %.4lf s\n", g.n, g.m / 2, start_strong_reduce.get_time() / 1e6);
-            strong_reduce_time += start_strong_reduce.get_time();
-
-            if (lb >= g.n)
-            {
-                g.n = 0;
-                StrongHeuris_time = t_extend.get_time();
-                print_heuris_log();
-                exit(0);
-            }
+            printf("unknown param: %s\n", argv[i]);
+            exit(1);
         }
     }
-    StrongHeuris_time = t_extend.get_time();
-}
-
-/**
- * @brief the newly proprosed heuris in kPlexT
- */
-void EgoHeuris()
-{
-    Timer t("ego-degen");
-    lb = g.ego_degen(&solution);
-    g.weak_reduce(lb);
-    t.print_time();
-    // strong reduce
+    string file_path = string(argv[1]);
+    int k1 = atoi(argv[2]), k2 = k1;
+    const char *dots = strstr(argv[2], "..");
+    if (dots != nullptr)
+        k2 = atoi(dots + 2);
+    if (k2 < k1)
     {
-        Timer start_strong_reduce;
-        Reduction reduce(&g);
-        ui pre_n = g.n;
-        reduce.strong_reduce(lb);
-        printf("Afer strong reduce, n= %u , m= %u, use time %.4lf s\n", g.n, g.m / 2, start_strong_reduce.get_time() / 1e6);
-        strong_reduce_time += start_strong_reduce.get_time();
-        if (lb >= g.n)
-        {
-            g.n = 0;
-            print_heuris_log();
-            exit(0);
-        }
+        printf("invalid range of k: %s\n", argv[2]);
+        exit(1);
     }
-}
-
-/**
- * @brief stage-I: we conduct heuristic and preprocessing stage
- * i.e., KPHeuris
- */
-void heuris()
-{
-    input_n = g.n;
-
-#ifdef EGO
-    EgoHeuris();
-    return;
-#endif
-
-    FastHeuris();
-    StrongHeuris(); // generate n subgraphs and compute larger lb
-}
-
-/**
- * @brief branch and bound searching
- */
-void bnb()
-{
-    Graph_reduced *G;
-    G = new Graph_reduced_adjacent_list(g);
-    Branch branch(*G, lb);
-    branch.IE_framework();                        // generate n subgraphs
-    if (solution.size() < branch.solution.size()) // record the max plex
+    paramK = k1; // only logged by readFromFile; Solver::solve binds it again
+    Graph g;
+    try
     {
-        solution.clear();
-        for (int v : branch.solution)
-            solution.insert(v);
+        g.readFromFile(file_path);
     }
-}
-
-int main(int argc, char *argv[])
-{
-    if (argc < 3)
+    catch (const exception &e)
     {
-        printf("2 params are required !!! \n");
-        printf("usage: ./kPEX graph_path k\n");
+        printf("%s\n", e.what());
         exit(1);
     }
-    file_path = string(argv[1]);
-    paramK = atoi(argv[2]);
-    g.readFromFile(file_path);
-
-    algorithm_start_time = get_system_time_microsecond();
-
-    // KPHeuris
-    puts("------------------{start KPHeuris}---------------------");
-    Timer prepro("heuristic and preprocess");
-    heuris();
-    prepro.print_time();
-    print_heuris_log();
 
-    // recursive branch and bound
-    puts("------------------{start BRB_Rec}---------------------");
-    bnb();
+    // sweep k1..k2: the graph is loaded and its core numbers are computed only once,
+    // and the solution for k-1 is the seed of k, since every (k-1)-plex is a k-plex
+    vector<ui> core;
+    if (k1 < k2)
+        core = g.get_core_numbers();
+    set<ui> seed;
+    vector<pair<ui, double>> results; // the size of solution and the time of each k
+    vector<const char *> answers;     // the answer of each k in decision mode
+    Timer sweep;
+    for (int k = k1; k <= k2; k++)
+    {
+        Solver solver(g, k, k1 < k2 ? &core : nullptr);
+        solver.set_seed(seed);
+        solver.set_target(target);
+        solver.set_anchors(anchors);
+        solver.solve();
+
+        if (anchors.size() && solver.solution.empty())
+            printf("The anchors are not a %d-plex!\n", k);
+        else if (anchors.size() && target == 0 && solver.solution.size() < 2 * k - 1)
+        {
+            printf("***We can't find a plex larger than 2k-2 that contains the anchors!! The anchors:\n");
+            print_set(solver.solution);
+        }
+        else if (target == 0)
+            print_solution(solver.solution, k);
+        else if (solver.is_target_reached())
+        {
+            printf("A k-plex with at least %d vertices(size= %d ):\n", target, (int)solver.solution.size());
+            print_set(solver.solution);
+        }
 
-    print_solution();
+        puts("------------------{whole procedure: kPEX}---------------------");
+        if (target > 0)
+        {
+            printf("target= %d , answer= %s , kPEX time: %.4lf s\n\n", target, get_answer(solver), solver.stats.total_time / 1e6);
+            answers.push_back(get_answer(solver));
+        }
+        else
+            printf("ground truth= %u , kPEX time: %.4lf s\n\n", solver.solution.size(), solver.stats.total_time / 1e6);
+        results.push_back({solver.solution.size(), solver.stats.total_time});
+        seed = solver.solution;
+    }
 
-    puts("------------------{whole procedure: kPEX}---------------------");
-    printf("ground truth= %u , kPEX time: %.4lf s\n\n", solution.size(), (get_system_time_microsecond() - algorithm_start_time) / 1e6);
+    if (k1 < k2)
+    {
+        puts("------------------{sweep of k: kPEX}---------------------");
+        for (int k = k1; k <= k2; k++)
+            if (target > 0)
+                printf("k= %d , target= %d , answer= %s , kPEX time: %.4lf s\n", k, target, answers[k - k1], results[k - k1].y / 1e6);
+            else
+                printf("k= %d , ground truth= %u , kPEX time: %.4lf s\n", k, results[k - k1].x, results[k - k1].y / 1e6);
+        printf("sweep time: %.4lf s\n\n", sweep.get_time() / 1e6);
+    }
 
     return 0;
-}
\ No newline at end of file
+}